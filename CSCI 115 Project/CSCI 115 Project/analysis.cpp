@@ -0,0 +1,103 @@
+#include "analysis.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// -----------------------------------------------------------
+// Private helper methods
+// -----------------------------------------------------------
+
+/**
+ * Returns the terms of model at n: f(n), and the second term or 0.
+ */
+static void model_terms(ComplexityModel model, double n, double &first, double &second) {
+	const double n_log_n = n * std::log2(n);
+	second = 0;
+	switch (model) {
+		case N_SQUARED: first = n * n; break;
+		case N_LOG_N:   first = n_log_n; break;
+		case LINEAR:    first = n; break;
+		default:        first = n_log_n; second = n; break;
+	}
+}
+
+// -----------------------------------------------------------
+// Public API
+// -----------------------------------------------------------
+
+char const *model_name(ComplexityModel model) {
+	static char const *const names[] = { "a*n^2", "a*n*log(n)", "a*n", "a*n*log(n)+b*n" };
+	return names[model];
+}
+
+std::vector<ComplexityFit> fit_complexity(std::vector<double> const &sizes, std::vector<double> const &costs, double min_size) {
+	std::vector<double> n, y;
+	for (std::size_t i = 0; i < sizes.size() && i < costs.size(); ++i) {
+		if (sizes[i] < min_size || sizes[i] < 2 || costs[i] <= 0) continue;
+		n.push_back(sizes[i]);
+		y.push_back(costs[i]);
+	}
+	std::vector<ComplexityFit> fits;
+	if (n.size() < 3) return fits;
+
+	double mean = 0;
+	for (double v : y) mean += v;
+	mean /= y.size();
+
+	double best_score = std::numeric_limits<double>::infinity();
+	std::size_t best = 0;
+	for (int m = 0; m < NUM_MODELS; ++m) {
+		const ComplexityModel model = static_cast<ComplexityModel>(m);
+		const bool two_terms = model == N_LOG_N_PLUS_N;
+
+		// Weighted least squares with weights 1 / y^2 minimizes the
+		// squared relative error
+		double s11 = 0, s12 = 0, s22 = 0, s1y = 0, s2y = 0;
+		for (std::size_t i = 0; i < n.size(); ++i) {
+			double f1, f2;
+			model_terms(model, n[i], f1, f2);
+			const double w = 1 / (y[i] * y[i]);
+			s11 += w * f1 * f1;
+			s12 += w * f1 * f2;
+			s22 += w * f2 * f2;
+			s1y += w * f1 * y[i];
+			s2y += w * f2 * y[i];
+		}
+
+		ComplexityFit fit;
+		fit.model = model;
+		fit.best = false;
+		fit.b = 0;
+		const double determinant = s11 * s22 - s12 * s12;
+		if (two_terms && std::abs(determinant) > 1e-12 * s11 * s22) {
+			fit.a = (s1y * s22 - s2y * s12) / determinant;
+			fit.b = (s2y * s11 - s1y * s12) / determinant;
+		} else {
+			fit.a = s1y / s11;
+		}
+
+		double squared_residuals = 0, squared_deviations = 0, squared_relative = 0;
+		for (std::size_t i = 0; i < n.size(); ++i) {
+			double f1, f2;
+			model_terms(model, n[i], f1, f2);
+			const double residual = fit.a * f1 + fit.b * f2 - y[i];
+			squared_residuals += residual * residual;
+			squared_deviations += (y[i] - mean) * (y[i] - mean);
+			squared_relative += (residual / y[i]) * (residual / y[i]);
+		}
+		fit.r_squared = squared_deviations > 0 ? 1 - squared_residuals / squared_deviations : 1;
+		fit.rms_relative_error = std::sqrt(squared_relative / n.size());
+
+		// Akaike's information criterion on the relative errors, so the
+		// two-term model has to earn its extra parameter
+		const double parameters = two_terms ? 2 : 1;
+		const double score = n.size() * std::log(std::max(squared_relative / n.size(), 1e-300)) + 2 * parameters;
+		if (score < best_score) {
+			best_score = score;
+			best = fits.size();
+		}
+		fits.push_back(fit);
+	}
+	fits[best].best = true;
+	return fits;
+}
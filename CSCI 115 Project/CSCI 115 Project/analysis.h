@@ -0,0 +1,179 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+#include "benchmark.h"
+
+// -----------------------------------------------------------
+// Analysis of sweeps
+//
+// Fits the measurements of every algorithm and dataset of a ResultTable to
+// textbook complexity models, and finds the input size at which one
+// algorithm overtakes another, measuring sizes between the powers of two
+// of the sweep to pin the crossover down.
+// -----------------------------------------------------------
+
+/**
+ * Models of a cost y at input size n, log being base 2.
+ */
+enum ComplexityModel { N_SQUARED, N_LOG_N, LINEAR, N_LOG_N_PLUS_N, NUM_MODELS };
+
+/**
+ * Returns the model as a formula, such as "a*n*log(n)".
+ */
+char const *model_name(ComplexityModel model);
+
+/**
+ * A model fitted to measurements: y = a * f(n), plus b * n for
+ * N_LOG_N_PLUS_N. r_squared is the coefficient of determination and
+ * rms_relative_error the typical error of the fit relative to the
+ * measurement, which, unlike r_squared, the largest sizes do not dominate.
+ * best marks the model of a set of fits that explains the data best
+ * without needing more parameters than it has to.
+ */
+struct ComplexityFit {
+	ComplexityModel model;
+	double a;
+	double b;
+	double r_squared;
+	double rms_relative_error;
+	bool best;
+};
+
+/**
+ * Fits every model to the points (sizes[i], costs[i]) by least squares on
+ * the relative error, so small and large sizes count alike. Points with a
+ * size below min_size, where fixed overheads rather than the algorithm
+ * dominate, or without a positive cost are ignored. Returns no fits with
+ * fewer than three points.
+ */
+std::vector<ComplexityFit> fit_complexity(std::vector<double> const &sizes, std::vector<double> const &costs, double min_size);
+
+/**
+ * What a cost of a cell is fitted or compared by.
+ */
+enum CostMetric { TIME, COMPARISONS };
+
+/**
+ * Returns the median time or the comparisons of cell.
+ */
+inline double cell_cost(CellResult const &cell, CostMetric metric)
+{
+	return metric == TIME ? cell.time.median : static_cast<double>(cell.ops.comparisons);
+}
+
+/**
+ * Fits every algorithm and dataset of table and writes one CSV row per
+ * model: algorithm, dataset, metric, model, a, b, r_squared,
+ * rms_relative_error and best.
+ */
+template <typename T>
+void write_complexity_fits(std::ostream &csv, ResultTable<T> const &table, double min_size)
+{
+	static char const *const metric_names[] = { "time_ns", "comparisons" };
+
+	csv << "algorithm,dataset,metric,model,a,b,r_squared,rms_relative_error,best\n";
+	for (std::size_t a = 0; a < table.algorithms().size(); ++a) {
+		for (std::size_t d = 0; d < table.datasets().size(); ++d) {
+			for (CostMetric metric : { TIME, COMPARISONS }) {
+				std::vector<double> sizes, costs;
+				for (std::size_t s = 0; s < table.sizes().size(); ++s) {
+					CellResult const &cell = table.at(a, d, s);
+					if (cell.status == CellResult::SKIPPED) continue;
+					sizes.push_back(static_cast<double>(table.sizes()[s]));
+					costs.push_back(cell_cost(cell, metric));
+				}
+				for (auto const &fit : fit_complexity(sizes, costs, min_size)) {
+					csv << table.algorithms()[a].name << "," << table.datasets()[d].name << ","
+					    << metric_names[metric] << "," << model_name(fit.model) << ","
+					    << fit.a << "," << fit.b << "," << fit.r_squared << ","
+					    << fit.rms_relative_error << "," << (fit.best ? 1 : 0) << "\n";
+				}
+			}
+		}
+	}
+}
+
+/**
+ * The size from which on winner is faster than loser on dataset, for good:
+ * winner is faster at crossover and every larger size measured, loser at
+ * below, the largest size measured that is smaller. refined is set when
+ * sizes between the two were measured to find crossover exactly.
+ */
+struct Crossover {
+	std::size_t winner;
+	std::size_t loser;
+	std::size_t dataset;
+	std::size_t below;
+	std::size_t crossover;
+	bool refined;
+};
+
+/**
+ * Finds the crossover of every pair of algorithms of table on every
+ * dataset from the sizes of the sweep. Pairs where one algorithm is faster
+ * at every size have none. Only the last change of the lead counts, as
+ * the lead may change back and forth among tiny sizes where the timings
+ * are mostly noise.
+ */
+template <typename T>
+std::vector<Crossover> find_crossovers(ResultTable<T> const &table)
+{
+	std::vector<Crossover> crossovers;
+	const std::size_t num_algorithms = table.algorithms().size();
+	for (std::size_t d = 0; d < table.datasets().size(); ++d) {
+		for (std::size_t x = 0; x < num_algorithms; ++x) {
+			for (std::size_t y = x + 1; y < num_algorithms; ++y) {
+				// Sizes measured for both, newest first
+				std::vector<std::size_t> both;
+				for (std::size_t s = table.sizes().size(); s-- > 0; ) {
+					if (table.at(x, d, s).status != CellResult::SKIPPED && table.at(y, d, s).status != CellResult::SKIPPED)
+						both.push_back(s);
+				}
+				if (both.size() < 2) continue;
+
+				auto x_faster = [&](std::size_t s) { return table.at(x, d, s).time.median < table.at(y, d, s).time.median; };
+				const bool x_wins = x_faster(both[0]);
+				std::size_t i = 1;
+				while (i < both.size() && x_faster(both[i]) == x_wins) ++i;
+				if (i == both.size()) continue;
+
+				Crossover crossover;
+				crossover.winner = x_wins ? x : y;
+				crossover.loser = x_wins ? y : x;
+				crossover.dataset = d;
+				crossover.below = table.sizes()[both[i]];
+				crossover.crossover = table.sizes()[both[i - 1]];
+				crossover.refined = false;
+				crossovers.push_back(crossover);
+			}
+		}
+	}
+	return crossovers;
+}
+
+/**
+ * Narrows crossover down by binary search over the sizes between below and
+ * crossover, measuring both algorithms at each size probed, until the two
+ * sizes are adjacent or max_probes sizes were measured.
+ */
+template <typename T>
+void refine_crossover(ResultTable<T> const &table, Crossover &crossover, BenchmarkConfig const &config, std::size_t max_probes)
+{
+	Algorithm<T> const &winner = table.algorithms()[crossover.winner];
+	Algorithm<T> const &loser = table.algorithms()[crossover.loser];
+	Dataset<T> const &dataset = table.datasets()[crossover.dataset];
+
+	for (std::size_t probe = 0; probe < max_probes && crossover.crossover - crossover.below > 1; ++probe) {
+		const std::size_t mid = crossover.below + (crossover.crossover - crossover.below) / 2;
+		const double winner_time = benchmark_cell(winner, dataset, mid, config).time.median;
+		const double loser_time = benchmark_cell(loser, dataset, mid, config).time.median;
+		if (winner_time < loser_time) crossover.crossover = mid;
+		else crossover.below = mid;
+	}
+	crossover.refined = true;
+}
+
+#endif
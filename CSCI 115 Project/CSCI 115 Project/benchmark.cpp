@@ -1,174 +1,754 @@
 #include "benchmark.h"
 #include "profile.h"
+#include "random.h"
 #include "sort_algs.h"
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#include <atomic>
+#include <fstream>
+#include <set>
+#include <mutex>
+#include <new>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#	include <sys/mman.h>
+#	define BENCHMARK_HAVE_MLOCK 1
+#else
+#	define BENCHMARK_HAVE_MLOCK 0
+#endif
+
+#if defined(__GLIBC__)
+#	include <malloc.h>
+#	define BENCHMARK_HAVE_HEAP_TRACKING 1
+#else
+#	define BENCHMARK_HAVE_HEAP_TRACKING 0
+#endif
+
+#if defined(__linux__)
+#	include <sched.h>
+#	define BENCHMARK_HAVE_AFFINITY 1
+#else
+#	define BENCHMARK_HAVE_AFFINITY 0
+#endif
 
 // -----------------------------------------------------------
 // Data type definitions
 // -----------------------------------------------------------
 
-using std::chrono::duration_cast;
-using std::chrono::microseconds;
-using SortFunction = void (*)(std::vector<int>::iterator, std::vector<int>::iterator, unsigned long&);
-
-struct BenchmarkInput {
-	std::vector<int> unsorted;
-	std::vector<int> sorted;
-	std::vector<int> rsorted;
-	std::vector<int> psorted_25;
-	std::vector<int> psorted_50;
-	std::vector<int> psorted_75;
-	std::vector<int> few_unique;
-	std::size_t input_size;
-	std::size_t num_trials;
-
-    BenchmarkInput(std::size_t input_size, std::size_t num_trials): 
-		input_size(input_size), 
-		num_trials(num_trials),
-		unsorted(input_size, 0), 
-		sorted(input_size, 0), 
-		rsorted(input_size, 0), 
-		psorted_25(input_size, 0),
-		psorted_50(input_size, 0),
-		psorted_75(input_size, 0),
-		few_unique(input_size, 0) {}
-};
+template <typename T>
+using SortFunction = void (*)(typename std::vector<T>::iterator, typename std::vector<T>::iterator, OpCounter&);
 
-struct ForwardGenerator {
-	int curr;
-	ForwardGenerator(): curr{0} {}
-	int operator()() { return curr++; }
-};
+// -----------------------------------------------------------
+// Heap accounting
+//
+// The global allocation functions are replaced to keep track of the heap
+// memory a sort allocates, in usable bytes as the allocator rounds them.
+// Tracking is switched on for one untimed run at a time, and costs the
+// timed runs a single flag test per allocation.
+// -----------------------------------------------------------
 
-struct BackwardsGenerator {
-	int curr;
-	BackwardsGenerator(int max): curr{max} {}
-	int operator()() { return curr--; }
-};
+#if BENCHMARK_HAVE_HEAP_TRACKING
+static std::atomic<bool> heap_tracking(false);
+static std::atomic<long long> heap_in_use(0);
+static std::atomic<long long> heap_peak(0);
 
-struct RandomGenerator {
-	int max_val;
-	RandomGenerator(int max): max_val{max} {}
-	int operator()() { return std::rand() % max_val; }
-};
+static void track_allocation(void *memory) {
+	if (!memory || !heap_tracking.load(std::memory_order_relaxed)) return;
+	const long long bytes = malloc_usable_size(memory);
+	const long long in_use = heap_in_use.fetch_add(bytes) + bytes;
+	long long peak = heap_peak.load();
+	while (in_use > peak && !heap_peak.compare_exchange_weak(peak, in_use)) {}
+}
 
-struct PSortedGenerator {
-	std::size_t num_sorted;
-	std::size_t curr;
-	std::size_t max_val; 
-	PSortedGenerator(std::size_t input_size, double ratio): 
-		num_sorted{static_cast<std::size_t>(input_size * ratio)}, 
-		curr{0},
-		max_val{input_size} {}
-	int operator()() { 
-		return curr > num_sorted ? std::rand() % max_val : ++curr;
+static void track_free(void *memory) {
+	if (!memory || !heap_tracking.load(std::memory_order_relaxed)) return;
+	heap_in_use.fetch_sub(malloc_usable_size(memory));
+}
+
+void *operator new(std::size_t bytes) {
+	for (;;) {
+		void *memory = std::malloc(bytes == 0 ? 1 : bytes);
+		if (memory) {
+			track_allocation(memory);
+			return memory;
+		}
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) throw std::bad_alloc();
+		handler();
 	}
-};
+}
+
+void *operator new[](std::size_t bytes) { return ::operator new(bytes); }
+
+void *operator new(std::size_t bytes, std::nothrow_t const &) noexcept {
+	void *memory = std::malloc(bytes == 0 ? 1 : bytes);
+	track_allocation(memory);
+	return memory;
+}
+
+void *operator new[](std::size_t bytes, std::nothrow_t const &tag) noexcept { return ::operator new(bytes, tag); }
+
+// Kept out of line: once inlined next to operator new, GCC takes its free
+// for a mismatched deallocation.
+__attribute__((noinline)) void operator delete(void *memory) noexcept {
+	track_free(memory);
+	std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept { ::operator delete(memory); }
+void operator delete(void *memory, std::nothrow_t const &) noexcept { ::operator delete(memory); }
+void operator delete[](void *memory, std::nothrow_t const &) noexcept { ::operator delete(memory); }
+
+/**
+ * Runs sort with heap tracking on and returns the most memory it had
+ * allocated at any time beyond what was in use when it started. Memory
+ * allocated before and freed during the run counts against that.
+ */
+template <typename F>
+static std::size_t peak_heap_of(F sort) {
+	heap_in_use = 0;
+	heap_peak = 0;
+	heap_tracking = true;
+	sort();
+	heap_tracking = false;
+	return static_cast<std::size_t>(heap_peak.load());
+}
+#endif
 
 // -----------------------------------------------------------
 // Private helper methods
 // -----------------------------------------------------------
 
-static RuntimeRecord benchmark_one(SortFunction sort, BenchmarkInput const &input, bool use_ptei=true) {
-    RuntimeRecord record;
-	const std::size_t N = input.num_trials;
-
-    for (auto i = 0; i < N; ++i) {
-        if (i % (N / 10) == 0)
-            std::cout << "." << std::flush;
-        
-        std::vector<int> unsorted    = input.unsorted;
-        std::vector<int> sorted      = input.sorted;
-		std::vector<int> rsorted     = input.rsorted;
-		std::vector<int> psorted_25  = input.psorted_25;
-		std::vector<int> psorted_50  = input.psorted_50;
-		std::vector<int> psorted_75  = input.psorted_75;
-		std::vector<int> few_unique  = input.few_unique;
-
-        record.unsorted   += profile(sort, unsorted.begin(), unsorted.end() - (use_ptei ? 0 : 1), record.unsorted_count);
-		record.sorted     += profile(sort, sorted.begin(), sorted.end() - (use_ptei ? 0 : 1), record.sorted_count);
-		record.rsorted    += profile(sort, rsorted.begin(),  rsorted.end() - (use_ptei ? 0 : 1), record.rsorted_count);
-		record.psorted_25 += profile(sort, psorted_25.begin(), psorted_25.end() - (use_ptei ? 0 : 1), record.psorted_25_count);;
-		record.psorted_50 += profile(sort, psorted_50.begin(), psorted_50.end() - (use_ptei ? 0 : 1), record.psorted_50_count);;
-		record.psorted_75 += profile(sort, psorted_75.begin(), psorted_75.end() - (use_ptei ? 0 : 1), record.psorted_75_count);;
-		record.few_unique += profile(sort, few_unique.begin(), few_unique.end() - (use_ptei ? 0 : 1), record.few_unique_count);;
-    }
-
-	record.unsorted   = microseconds(record.unsorted.count() / N);
-	record.sorted     = microseconds(record.sorted.count() / N);;
-	record.rsorted    = microseconds(record.rsorted.count() / N);;
-	record.psorted_25 = microseconds(record.psorted_25.count() / N);;
-	record.psorted_50 = microseconds(record.psorted_50.count() / N);;
-	record.psorted_75 = microseconds(record.psorted_75.count() / N);;
-	record.few_unique = microseconds(record.few_unique.count() / N);
-
-	record.unsorted_count   = (record.unsorted_count / (unsigned long)N);
-	record.sorted_count     = (record.sorted_count / (unsigned long)N);;
-	record.rsorted_count    = (record.rsorted_count / (unsigned long)N);;
-	record.psorted_25_count = (record.psorted_25_count / (unsigned long)N);
-	record.psorted_50_count = (record.psorted_50_count / (unsigned long)N);
-	record.psorted_75_count = (record.psorted_75_count / (unsigned long)N);
-	record.few_unique_count	= (record.few_unique_count / (unsigned long)N);
-
-    return record;
+/**
+ * Locks a buffer into RAM for the lifetime of the object, so no trial takes
+ * a page fault on it. Failing to lock, for example beyond RLIMIT_MEMLOCK,
+ * is not an error: the buffer is then only prefaulted.
+ */
+class MemoryLock {
+public:
+	MemoryLock(void const *data, std::size_t bytes, bool enabled): data(data), bytes(bytes), locked(false) {
+#if BENCHMARK_HAVE_MLOCK
+		if (enabled && bytes > 0) locked = mlock(data, bytes) == 0;
+#else
+		(void)enabled;
+#endif
+	}
+
+	~MemoryLock() {
+#if BENCHMARK_HAVE_MLOCK
+		if (locked) munlock(data, bytes);
+#endif
+	}
+
+	MemoryLock(MemoryLock const &) = delete;
+	MemoryLock &operator=(MemoryLock const &) = delete;
+
+private:
+	void const *data;
+	std::size_t bytes;
+	bool locked;
+};
+
+/**
+ * Copies data over working, which has the same size: with a memcpy for
+ * plain values, and element by element otherwise, where strings reuse the
+ * buffers they already own.
+ */
+template <typename T>
+static void restore(std::vector<T> &working, std::vector<T> const &data, std::true_type) {
+	std::memcpy(working.data(), data.data(), data.size() * sizeof(T));
+}
+
+template <typename T>
+static void restore(std::vector<T> &working, std::vector<T> const &data, std::false_type) {
+	std::copy(data.begin(), data.end(), working.begin());
+}
+
+template <typename T>
+static void restore(std::vector<T> &working, std::vector<T> const &data) {
+	restore(working, data, std::is_trivially_copyable<T>());
+}
+
+/**
+ * Benchmarks Sort on data. Every run sorts working, which the caller
+ * allocated and touched once up front, after restoring it from data
+ * outside the timed region. The textbook quick sorts take an inclusive
+ * last iterator, which InclusiveEnd accounts for.
+ */
+template <typename T, SortFunction<T> Sort, bool InclusiveEnd>
+static CellResult run_cell(std::vector<T> const &data, std::vector<T> &working, BenchmarkConfig const &config) {
+	CellResult record;
+	const std::size_t end_offset = InclusiveEnd ? 1 : 0;
+
+	for (std::size_t i = 0; i < config.warmup_runs; ++i) {
+		restore(working, data);
+		OpCounter ignored;
+		auto sort = [&]() { Sort(working.begin(), working.end() - end_offset, ignored); };
+#if BENCHMARK_HAVE_HEAP_TRACKING
+		if (i == 0 && config.measure_memory) {
+			record.peak_memory = peak_heap_of(sort);
+			record.memory_measured = true;
+			continue;
+		}
+#endif
+		sort();
+	}
+
+	std::vector<double> samples;
+	while (samples.size() < config.max_trials) {
+		restore(working, data);
+		ProfileResult run = profile_counters(Sort, working.begin(), working.end() - end_offset, record.ops);
+		samples.push_back(static_cast<double>(run.time.count()));
+		record.hw += run.counters;
+
+		if (samples.size() >= config.min_trials && relative_confidence_interval(samples) <= config.target_ci)
+			break;
+	}
+
+	const unsigned long trials = std::max<std::size_t>(samples.size(), 1);
+	record.ops.comparisons /= trials;
+	record.ops.moves /= trials;
+	record.hw /= trials;
+	record.time = summarize(samples, data.size(), config.reject_outliers);
+	return record;
+}
+
+#if BENCHMARK_HAVE_AFFINITY
+/**
+ * Returns the lowest numbered hardware thread on the physical core of cpu,
+ * or cpu itself when the topology cannot be read.
+ */
+static int first_sibling(int cpu) {
+	std::ifstream siblings("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+	int first = cpu;
+	if (!(siblings >> first)) return cpu;
+	return first;
+}
+#endif
+
+/**
+ * Restricts the calling thread to cpus, and the threads it starts from then
+ * on, which inherit its affinity. An empty list leaves it as it is.
+ */
+static void restrict_current_thread(std::vector<int> const &cpus) {
+#if BENCHMARK_HAVE_AFFINITY
+	if (cpus.empty()) return;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (int cpu : cpus) CPU_SET(cpu, &set);
+	sched_setaffinity(0, sizeof(set), &set);
+#else
+	(void)cpus;
+#endif
+}
+
+/**
+ * Restricts the calling thread to cpu.
+ */
+static void pin_current_thread(int cpu) {
+	restrict_current_thread(std::vector<int>(1, cpu));
+}
+
+/**
+ * The number of earlier sizes a cell's time is extrapolated from. The
+ * latest ones describe the next size best, as caches stop fitting the data.
+ */
+static const std::size_t PREDICTION_POINTS = 3;
+
+/**
+ * Measures cell with algorithm as planned, keeping the status and
+ * prediction plan_cell gave it. Skipped cells are left alone.
+ */
+template <typename T>
+static void measure_cell(Algorithm<T> const &algorithm, std::vector<T> const &data, std::vector<T> &working, BenchmarkConfig const &config, CellResult &cell) {
+	if (cell.status == CellResult::SKIPPED) return;
+
+	const CellResult::Status status = cell.status;
+	const double predicted_ns = cell.predicted_ns;
+	cell = algorithm.run(data, working, config);
+	cell.status = status;
+	cell.predicted_ns = predicted_ns;
+}
+
+/**
+ * Derives the seed of a dataset at one size from the seed of the run. It
+ * goes by the dataset's name rather than its position, so that selecting
+ * other datasets does not change the data of this one.
+ */
+static std::uint64_t dataset_seed(std::uint64_t seed, char const *name, std::size_t input_size) {
+	// FNV-1a
+	std::uint64_t hash = 14695981039346656037ULL;
+	for (char const *c = name; *c; ++c) hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ULL;
+	std::uint64_t x = seed ^ hash;
+	return splitmix64(x) ^ input_size;
+}
+
+/**
+ * The number of elements generated from one random stream. It is fixed,
+ * so that the data depends on the seed only and not on the thread count.
+ */
+static const std::size_t GENERATOR_CHUNK = 1 << 16;
+
+/**
+ * Calls fill(first, last, rng) for every chunk [first, last) of
+ * GENERATOR_CHUNK elements of data, on every hardware thread, rng being the
+ * chunk's own stream of seed.
+ */
+template <typename T, typename Fill>
+static void parallel_fill(std::vector<T> &data, std::uint64_t seed, Fill fill) {
+	const std::size_t chunks = (data.size() + GENERATOR_CHUNK - 1) / GENERATOR_CHUNK;
+	std::atomic<std::size_t> next(0);
+	auto worker = [&]() {
+		for (std::size_t c = next++; c < chunks; c = next++) {
+			Xoshiro256 rng(seed, c);
+			const std::size_t first = c * GENERATOR_CHUNK;
+			fill(first, std::min(first + GENERATOR_CHUNK, data.size()), rng);
+		}
+	};
+
+	const std::size_t threads = std::min<std::size_t>(default_thread_count(), chunks);
+	std::vector<std::thread> workers;
+	for (std::size_t t = 1; t < threads; ++t) workers.emplace_back(worker);
+	worker();
+	for (auto &thread : workers) thread.join();
+}
+
+template <typename T>
+static void generate_unsorted(std::vector<T> &data, std::uint64_t seed) {
+	const std::size_t n = data.size();
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &rng) {
+		for (std::size_t i = first; i < last; ++i) data[i] = make_value<T>(uniform_below(rng, n));
+	});
+}
+
+template <typename T>
+static void generate_sorted(std::vector<T> &data, std::uint64_t seed) {
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &) {
+		for (std::size_t i = first; i < last; ++i) data[i] = make_value<T>(i);
+	});
+}
+
+template <typename T>
+static void generate_reverse_sorted(std::vector<T> &data, std::uint64_t seed) {
+	const std::size_t n = data.size();
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &) {
+		for (std::size_t i = first; i < last; ++i) data[i] = make_value<T>(n - i);
+	});
+}
+
+/**
+ * A sorted prefix of Percent percent of the elements, then random values.
+ */
+template <typename T, int Percent>
+static void generate_partially_sorted(std::vector<T> &data, std::uint64_t seed) {
+	const std::size_t n = data.size();
+	const std::size_t num_sorted = static_cast<std::size_t>(n * (Percent / 100.0));
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &rng) {
+		for (std::size_t i = first; i < last; ++i)
+			data[i] = make_value<T>(i <= num_sorted ? i + 1 : uniform_below(rng, n));
+	});
+}
+
+template <typename T>
+static void generate_few_unique(std::vector<T> &data, std::uint64_t seed) {
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &rng) {
+		for (std::size_t i = first; i < last; ++i) data[i] = make_value<T>(uniform_below(rng, 10));
+	});
+}
+
+/**
+ * Values 0..n-1 drawn from a Zipf distribution with exponent 1: 0 is the
+ * most common value, the next one half as common and so on, as with word
+ * frequencies or the popularity of keys in a cache.
+ */
+template <typename T>
+static void generate_zipf(std::vector<T> &data, std::uint64_t seed) {
+	const ZipfDistribution zipf(std::max<std::size_t>(data.size(), 1), 1.0);
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &rng) {
+		for (std::size_t i = first; i < last; ++i) data[i] = make_value<T>(zipf(rng) - 1);
+	});
+}
+
+/**
+ * Normally distributed values around n / 2 with a standard deviation of
+ * n / 8, so most values fall in the middle of the range and many repeat.
+ */
+template <typename T>
+static void generate_gaussian(std::vector<T> &data, std::uint64_t seed) {
+	const double n = static_cast<double>(data.size());
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &rng) {
+		for (std::size_t i = first; i < last; ++i) data[i] = make_value<T>(std::llround(normal(rng, n / 2, n / 8)));
+	});
+}
+
+/**
+ * Ascending to the middle, then descending: 0, 1, 2, ..., 2, 1, 0.
+ */
+template <typename T>
+static void generate_organ_pipe(std::vector<T> &data, std::uint64_t seed) {
+	const std::size_t n = data.size();
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &) {
+		for (std::size_t i = first; i < last; ++i) data[i] = make_value<T>(i < n / 2 ? i : n - 1 - i);
+	});
+}
+
+/**
+ * About sqrt(n) ascending runs of about sqrt(n) elements each.
+ */
+template <typename T>
+static void generate_sawtooth(std::vector<T> &data, std::uint64_t seed) {
+	const std::size_t period = std::max<std::size_t>(static_cast<std::size_t>(std::sqrt(static_cast<double>(data.size()))), 1);
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &) {
+		for (std::size_t i = first; i < last; ++i) data[i] = make_value<T>(i % period);
+	});
+}
+
+/**
+ * Sorted, then Percent percent of n swaps of two random elements each, so
+ * the disorder is spread over the whole input rather than at its end as
+ * with generate_partially_sorted. Every generator chunk makes its own
+ * swaps within itself, so no element moves further than GENERATOR_CHUNK.
+ */
+template <typename T, int Percent>
+static void generate_random_swaps(std::vector<T> &data, std::uint64_t seed) {
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &rng) {
+		for (std::size_t i = first; i < last; ++i) data[i] = make_value<T>(i);
+		const std::size_t size = last - first;
+		for (std::size_t k = size * Percent / 100; k > 0; --k)
+			std::swap(data[first + uniform_below(rng, size)], data[first + uniform_below(rng, size)]);
+	});
+}
+
+/**
+ * Random values in sorted blocks of about sqrt(n) elements, rounded down to
+ * a power of two so that every block lies within one generator chunk.
+ */
+template <typename T>
+static void generate_sorted_blocks(std::vector<T> &data, std::uint64_t seed) {
+	const std::size_t n = data.size();
+	std::size_t block = 1;
+	while (block * block * 4 <= n && block * 2 <= GENERATOR_CHUNK) block *= 2;
+
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &rng) {
+		for (std::size_t i = first; i < last; ++i) data[i] = make_value<T>(uniform_below(rng, n));
+		for (std::size_t b = first; b < last; b += block)
+			std::sort(data.begin() + b, data.begin() + std::min(b + block, last));
+	});
+}
+
+template <typename T>
+static void generate_all_equal(std::vector<T> &data, std::uint64_t seed) {
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &) {
+		std::fill(data.begin() + first, data.begin() + last, make_value<T>(0));
+	});
+}
+
+/**
+ * Uniform over the whole 64-bit range of keys, negative ones included,
+ * rather than over 0..n-1, so radix sorts see every digit vary. Narrower
+ * integer types get uniform values over their own range.
+ */
+template <typename T>
+static void generate_full_range(std::vector<T> &data, std::uint64_t seed) {
+	parallel_fill(data, seed, [&](std::size_t first, std::size_t last, Xoshiro256 &rng) {
+		for (std::size_t i = first; i < last; ++i) data[i] = make_value<T>(static_cast<std::int64_t>(rng()));
+	});
+}
+
+// -----------------------------------------------------------
+// Registry
+// -----------------------------------------------------------
+
+/**
+ * lsd_radix_sort only sorts integers. For other value types its entry has
+ * no runner and is left out of the registry.
+ */
+template <typename T>
+static CellRunner<T> radix_sort_cell(std::true_type) {
+	return run_cell<T, lsd_radix_sort, false>;
+}
+
+template <typename T>
+static CellRunner<T> radix_sort_cell(std::false_type) {
+	return nullptr;
+}
+
+/**
+ * Returns the entries of table that have a runner for T.
+ */
+template <typename T, std::size_t N>
+static std::vector<Algorithm<T>> runnable(Algorithm<T> const (&table)[N]) {
+	std::vector<Algorithm<T>> algorithms;
+	for (auto const &algorithm : table)
+		if (algorithm.run) algorithms.push_back(algorithm);
+	return algorithms;
 }
 
 // -----------------------------------------------------------
 // Public API
 // -----------------------------------------------------------
 
-BenchmarkResults benchmark(std::size_t input_size, std::size_t num_trials) {
-    BenchmarkInput input(input_size, num_trials);
-	BenchmarkResults results;
-
-	std::generate(input.unsorted.begin(),  input.unsorted.end(), RandomGenerator(input_size));
-	std::generate(input.sorted.begin(),  input.sorted.end(),  ForwardGenerator());
-	std::generate(input.rsorted.begin(), input.rsorted.end(), BackwardsGenerator(input_size));
-	std::generate(input.psorted_25.begin(), input.psorted_25.end(), PSortedGenerator(input_size, 0.25));
-	std::generate(input.psorted_50.begin(), input.psorted_50.end(), PSortedGenerator(input_size, 0.50));
-	std::generate(input.psorted_75.begin(), input.psorted_75.end(), PSortedGenerator(input_size, 0.75));
-	std::generate(input.few_unique.begin(), input.few_unique.end(), RandomGenerator(10));
-
-	// Insertion Sort
-	std::cout << "Insertion Sort";
-    results.insertion_sort = benchmark_one(insertion_sort, input);
-	std::cout << "done" << std::endl;	
-
-	// Selection Sort
-	std::cout << "Selection Sort";
-    results.selection_sort = benchmark_one(selection_sort, input);
-	std::cout << "done" << std::endl;	
-
-	// Bubble Sort
-	std::cout << "Bubble Sort";
-    results.bubble_sort = benchmark_one(bubble_sort, input);
-	std::cout << "done" << std::endl;	
-
-	// Merge Sort
-	std::cout << "Merge Sort";
-    results.merge_sort = benchmark_one(merge_sort, input);
-	std::cout << "done" << std::endl;	
-
-	// Quick Sort
-	std::cout << "Quick Sort";
-    results.quick_sort = benchmark_one(quick_sort, input, false);
-	std::cout << "done" << std::endl;	
-
-	// Hoare Quick Sort
-	std::cout << "Hoare Quick Sort";
-    results.hoare_quick_sort = benchmark_one(hoare_quick_sort, input, false);
-	std::cout << "done" << std::endl;	
-
-	// Randomized Quick Sort
-	std::cout << "Randomized Quick Sort";
-    results.randomized_quick_sort = benchmark_one(randomized_quick_sort, input, false);
-	std::cout << "done" << std::endl;	
-
-	// Heap Sort
-	std::cout << "Heap Sort";
-    results.heap_sort = benchmark_one(heap_sort, input);
+template <typename T>
+BenchmarkConfig plan_cell(ResultTable<T> &table, std::size_t a, std::size_t d, std::size_t size_index, BenchmarkConfig const &config) {
+	const std::size_t max_size = table.algorithms()[a].max_size;
+	if (max_size != 0 && table.sizes()[size_index] > max_size) {
+		table.at(a, d, size_index).status = CellResult::SKIPPED;
+		return config;
+	}
+
+	std::vector<double> sizes, times;
+	for (std::size_t s = size_index; s-- > 0 && sizes.size() < PREDICTION_POINTS; ) {
+		CellResult const &earlier = table.at(a, d, s);
+		if (earlier.status == CellResult::SKIPPED || earlier.time.trials == 0) continue;
+		sizes.push_back(static_cast<double>(table.sizes()[s]));
+		times.push_back(earlier.time.median);
+	}
+
+	CellResult &cell = table.at(a, d, size_index);
+	cell.predicted_ns = predict_power_law(sizes, times, static_cast<double>(table.sizes()[size_index]));
+
+	BenchmarkConfig planned = config;
+	if (config.time_budget_ns <= 0 || cell.predicted_ns <= 0) return planned;
+
+	// Runs, warm-up included, that fit in the budget
+	const double affordable = config.time_budget_ns / cell.predicted_ns;
+	if (affordable >= config.warmup_runs + config.min_trials) {
+		const double trials = affordable - config.warmup_runs;
+		if (trials < config.max_trials) planned.max_trials = static_cast<std::size_t>(trials);
+	} else if (affordable >= 1) {
+		cell.status = CellResult::REDUCED;
+		planned.warmup_runs = 0;
+		planned.min_trials = planned.max_trials = static_cast<std::size_t>(affordable);
+	} else {
+		cell.status = CellResult::SKIPPED;
+	}
+	return planned;
+}
+
+template <typename T>
+std::vector<Algorithm<T>> const &registered_algorithms() {
+	static const Algorithm<T> table[] = {
+		{ "insertion",        run_cell<T, insertion_sort,        false>, false, 0 },
+		{ "selection",        run_cell<T, selection_sort,        false>, false, 0 },
+		{ "bubble",           run_cell<T, bubble_sort,           false>, false, 0 },
+		{ "merge",            run_cell<T, merge_sort,            false>, false, 0 },
+		{ "quick",            run_cell<T, quick_sort,            true>,  false, 0 },
+		{ "hoare-quick",      run_cell<T, hoare_quick_sort,      true>,  false, 0 },
+		{ "randomized-quick", run_cell<T, randomized_quick_sort, true>,  false, 0 },
+		{ "heap",             run_cell<T, heap_sort,             false>, false, 0 },
+		{ "intro",            run_cell<T, intro_sort,            false>, false, 0 },
+		{ "parallel-merge",   run_cell<T, parallel_merge_sort,   false>, true,  0 },
+		{ "parallel-sample",  run_cell<T, parallel_sample_sort,  false>, true,  0 },
+		{ "in-place-sample",  run_cell<T, in_place_sample_sort,  false>, true,  0 },
+		{ "lsd-radix",        radix_sort_cell<T>(std::is_integral<T>()), false, 0 },
+		{ "block-quick",      run_cell<T, block_quick_sort,      false>, false, 0 },
+		{ "tim",              run_cell<T, tim_sort,              false>, false, 0 },
+		{ "three-way-quick",  run_cell<T, three_way_quick_sort,  false>, false, 0 },
+		{ "dual-pivot-quick", run_cell<T, dual_pivot_quick_sort, false>, false, 0 },
+		// Insertion sort beyond the sizes the sorting network handles
+		{ "small",            run_cell<T, small_sort,            false>, false, SMALL_SORT_MAX },
+	};
+
+	static const std::vector<Algorithm<T>> algorithms = runnable(table);
+	return algorithms;
+}
+
+template <typename T>
+std::vector<Dataset<T>> const &registered_datasets() {
+	static const Dataset<T> table[] = {
+		{ "unsorted",            generate_unsorted<T> },
+		{ "sorted",              generate_sorted<T> },
+		{ "reverse_sorted",      generate_reverse_sorted<T> },
+		{ "partially_sorted_25", generate_partially_sorted<T, 25> },
+		{ "partially_sorted_50", generate_partially_sorted<T, 50> },
+		{ "partially_sorted_75", generate_partially_sorted<T, 75> },
+		{ "few_unique_10",       generate_few_unique<T> },
+		{ "zipf",                generate_zipf<T> },
+		{ "gaussian",            generate_gaussian<T> },
+		{ "organ_pipe",          generate_organ_pipe<T> },
+		{ "sawtooth",            generate_sawtooth<T> },
+		{ "random_swaps_1",      generate_random_swaps<T, 1> },
+		{ "sorted_blocks",       generate_sorted_blocks<T> },
+		{ "all_equal",           generate_all_equal<T> },
+		{ "full_range",          generate_full_range<T> },
+	};
+
+	static const std::vector<Dataset<T>> datasets(std::begin(table), std::end(table));
+	return datasets;
+}
+
+std::vector<int> benchmark_cpus(BenchmarkConfig const &config) {
+	std::vector<int> cpus = config.cpus;
+#if BENCHMARK_HAVE_AFFINITY
+	// As of the first call, before benchmark() restricted the main thread
+	static const std::vector<int> allowed_cpus = []() {
+		std::vector<int> allowed;
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+			for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+				if (CPU_ISSET(cpu, &set)) allowed.push_back(cpu);
+		}
+		return allowed;
+	}();
+	if (cpus.empty()) cpus = allowed_cpus;
+
+	// The first hardware thread of a CPU's physical core identifies the core
+	std::vector<int> cores;
+	for (int cpu : cpus) cores.push_back(first_sibling(cpu));
+
+	std::set<int> reserved;
+	for (int core : cores) {
+		if (reserved.size() >= config.reserved_cores) break;
+		reserved.insert(core);
+	}
+
+	std::vector<int> usable;
+	for (std::size_t i = 0; i < cpus.size(); ++i) {
+		if (reserved.count(cores[i])) continue;
+		if (config.idle_smt_siblings && cores[i] != cpus[i]) continue;
+		usable.push_back(cpus[i]);
+	}
+	return usable;
+#else
+	return std::vector<int>();
+#endif
+}
+
+template <typename T>
+CellResult benchmark_cell(Algorithm<T> const &algorithm, Dataset<T> const &dataset, std::size_t input_size, BenchmarkConfig const &config) {
+	std::vector<T> input(input_size), working(input_size);
+	dataset.generate(input, dataset_seed(config.seed, dataset.name, input_size));
+	MemoryLock working_lock(working.data(), working.size() * sizeof(T), config.lock_memory);
+	return algorithm.run(input, working, config);
+}
+
+template <typename T>
+std::size_t benchmark(ResultTable<T> &table, std::size_t input_size, BenchmarkConfig const &config) {
+	const std::size_t size_index = table.add_size(input_size);
+	std::vector<Dataset<T>> const &datasets = table.datasets();
+	std::vector<Algorithm<T>> const &algorithms = table.algorithms();
+
+	// The generators and the multithreaded sorts run on the usable CPUs,
+	// with a thread for each, and on no others
+	const std::vector<int> cpus = benchmark_cpus(config);
+	restrict_current_thread(cpus);
+	if (!cpus.empty()) set_default_thread_count(static_cast<unsigned>(cpus.size()));
+
+	std::vector<BenchmarkConfig> plans;
+	std::vector<bool> needed(datasets.size(), false);
+	for (std::size_t a = 0; a < algorithms.size(); ++a) {
+		for (std::size_t d = 0; d < datasets.size(); ++d) {
+			plans.push_back(plan_cell(table, a, d, size_index, config));
+			// Cells running alongside others would count their allocations
+			if (config.jobs != 1 && !algorithms[a].multithreaded) plans.back().measure_memory = false;
+			if (table.at(a, d, size_index).status != CellResult::SKIPPED) needed[d] = true;
+		}
+	}
+
+	// Inputs no cell is measured on are not even generated, which matters
+	// once a single dataset takes gigabytes
+	std::vector<std::vector<T>> inputs(datasets.size());
+	for (std::size_t d = 0; d < datasets.size(); ++d) {
+		if (!needed[d]) continue;
+		inputs[d].resize(input_size);
+		datasets[d].generate(inputs[d], dataset_seed(config.seed, datasets[d].name, input_size));
+	}
+
+	if (config.jobs == 1) {
+		std::vector<T> working(input_size);
+		MemoryLock working_lock(working.data(), working.size() * sizeof(T), config.lock_memory);
+
+		for (std::size_t a = 0; a < algorithms.size(); ++a) {
+			// Serial sorts run on the first usable CPU, like the first worker
+			if (!cpus.empty()) restrict_current_thread(algorithms[a].multithreaded ? cpus : std::vector<int>(1, cpus[0]));
+			std::cout << algorithms[a].name << " ";
+			for (std::size_t d = 0; d < datasets.size(); ++d) {
+				CellResult &cell = table.at(a, d, size_index);
+				measure_cell(algorithms[a], inputs[d], working, plans[a * datasets.size() + d], cell);
+				std::cout << (cell.status == CellResult::SKIPPED ? "-" : ".") << std::flush;
+			}
+			std::cout << "done" << std::endl;
+		}
+		restrict_current_thread(cpus);
+		return size_index;
+	}
+
+	unsigned jobs = config.jobs;
+	if (jobs == 0) jobs = std::max<std::size_t>(cpus.size(), 1);
+
+	// Longest cells first, going by their predicted time, so that no worker
+	// picks up a quadratic sort just as the others run out of work
+	std::vector<std::pair<std::size_t, std::size_t>> cells, multithreaded_cells;
+	for (std::size_t a = 0; a < algorithms.size(); ++a) {
+		for (std::size_t d = 0; d < datasets.size(); ++d) {
+			if (table.at(a, d, size_index).status == CellResult::SKIPPED) continue;
+			(algorithms[a].multithreaded ? multithreaded_cells : cells).push_back(std::make_pair(a, d));
+		}
+	}
+	std::stable_sort(cells.begin(), cells.end(), [&](std::pair<std::size_t, std::size_t> x, std::pair<std::size_t, std::size_t> y) {
+		return table.at(y.first, y.second, size_index).predicted_ns < table.at(x.first, x.second, size_index).predicted_ns;
+	});
+
+	std::atomic<std::size_t> next(0);
+	std::mutex output_lock;
+	auto worker = [&](unsigned index) {
+		if (!cpus.empty()) pin_current_thread(cpus[index % cpus.size()]);
+		// Opens the hardware counters of this worker, which count its cells alone
+		perf_counters();
+
+		std::vector<T> working(input_size);
+		MemoryLock working_lock(working.data(), working.size() * sizeof(T), config.lock_memory);
+
+		for (std::size_t i = next++; i < cells.size(); i = next++) {
+			const std::size_t a = cells[i].first, d = cells[i].second;
+			measure_cell(algorithms[a], inputs[d], working, plans[a * datasets.size() + d], table.at(a, d, size_index));
+
+			std::lock_guard<std::mutex> guard(output_lock);
+			std::cout << "." << std::flush;
+		}
+	};
+
+	std::cout << cells.size() << " cells on " << jobs << " workers ";
+	std::vector<std::thread> workers;
+	for (unsigned w = 0; w < jobs; ++w) workers.emplace_back(worker, w);
+	for (auto &thread : workers) thread.join();
 	std::cout << "done" << std::endl;
 
-	return results;
-}
\ No newline at end of file
+	// Cells of multithreaded algorithms get the machine to themselves
+	std::vector<T> working(input_size);
+	MemoryLock working_lock(working.data(), working.size() * sizeof(T), config.lock_memory);
+	for (std::size_t i = 0; i < multithreaded_cells.size(); ++i) {
+		const std::size_t a = multithreaded_cells[i].first, d = multithreaded_cells[i].second;
+		if (i == 0 || multithreaded_cells[i - 1].first != a) std::cout << algorithms[a].name << " ";
+		measure_cell(algorithms[a], inputs[d], working, plans[a * datasets.size() + d], table.at(a, d, size_index));
+		std::cout << "." << std::flush;
+		if (i + 1 == multithreaded_cells.size() || multithreaded_cells[i + 1].first != a) std::cout << "done" << std::endl;
+	}
+
+	return size_index;
+}
+
+// Every value type of value_types.h is benchmarked
+#define INSTANTIATE_BENCHMARK(T) \
+	template std::vector<Algorithm<T>> const &registered_algorithms<T>(); \
+	template std::vector<Dataset<T>> const &registered_datasets<T>(); \
+	template BenchmarkConfig plan_cell<T>(ResultTable<T> &table, std::size_t a, std::size_t d, std::size_t size_index, BenchmarkConfig const &config); \
+	template CellResult benchmark_cell<T>(Algorithm<T> const &algorithm, Dataset<T> const &dataset, std::size_t input_size, BenchmarkConfig const &config); \
+	template std::size_t benchmark<T>(ResultTable<T> &table, std::size_t input_size, BenchmarkConfig const &config);
+
+INSTANTIATE_BENCHMARK(int)
+INSTANTIATE_BENCHMARK(std::int64_t)
+INSTANTIATE_BENCHMARK(double)
+INSTANTIATE_BENCHMARK(std::string)
+INSTANTIATE_BENCHMARK(Record<32>)
+INSTANTIATE_BENCHMARK(Record<64>)
+INSTANTIATE_BENCHMARK(Record<128>)
@@ -1,54 +1,279 @@
 #ifndef BENCHMARK_H
 #define BENCHMARK_H
 
-#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "counters.h"
+#include "profile.h"
+#include "stats.h"
+#include "value_types.h"
 
-struct RuntimeRecord {
-	std::chrono::microseconds unsorted;
-	std::chrono::microseconds sorted;
-	std::chrono::microseconds rsorted;
-	std::chrono::microseconds psorted_25;
-	std::chrono::microseconds psorted_50;
-	std::chrono::microseconds psorted_75;
-	std::chrono::microseconds few_unique;
-
-	unsigned long unsorted_count;
-	unsigned long sorted_count;
-	unsigned long rsorted_count;
-	unsigned long psorted_25_count;
-	unsigned long psorted_50_count;
-	unsigned long psorted_75_count;
-	unsigned long few_unique_count;
-
-	RuntimeRecord(): 
-		unsorted(std::chrono::microseconds::zero()), 
-		sorted(std::chrono::microseconds::zero()), 
-		rsorted(std::chrono::microseconds::zero()), 
-		psorted_25(std::chrono::microseconds::zero()), 
-		psorted_50(std::chrono::microseconds::zero()), 
-		psorted_75(std::chrono::microseconds::zero()), 
-		few_unique(std::chrono::microseconds::zero()),
-		unsorted_count(0),
-		sorted_count(0),
-		rsorted_count(0),
-		psorted_25_count(0),
-		psorted_50_count(0),
-		psorted_75_count(0),
-		few_unique_count(0) {}
+/**
+ * How every cell of the benchmark is measured. Each cell gets warmup_runs
+ * untimed runs, then trials are added until the 95% confidence interval of
+ * the mean is within target_ci of the mean, but never fewer than min_trials
+ * or more than max_trials. With lock_memory the working buffer the sorts
+ * run on is locked into RAM with mlock where the platform allows it.
+ *
+ * With jobs above 1 independent cells run concurrently on that many worker
+ * threads, each pinned to its own CPU (0 means one per usable CPU). The
+ * usable CPUs are cpus, or every CPU the process may run on when cpus is
+ * empty, minus the first reserved_cores physical cores, and with
+ * idle_smt_siblings only the first hardware thread of every core. Every
+ * worker counts hardware events with counters of its own, so its cells
+ * get the same counts as with a single runner. With jobs 1 the single
+ * runner is pinned to the first usable CPU. Multithreaded sorts, and the
+ * generators of the inputs, get a thread on every usable CPU.
+ *
+ * A time_budget_ns above 0 caps the time spent measuring any one cell. The
+ * time of a run is predicted from the sizes measured before, and cells
+ * that would not fit get fewer trials or are skipped, see CellResult.
+ *
+ * With measure_memory the heap memory a sort allocates is measured in its
+ * first warm-up run, so cells without warm-up runs are not measured. The
+ * runner leaves it off for cells that run alongside others.
+ *
+ * Every input is generated from seed, so a run with the same seed sorts
+ * the same data.
+ */
+struct BenchmarkConfig {
+	std::size_t warmup_runs;
+	std::size_t min_trials;
+	std::size_t max_trials;
+	double target_ci;
+	bool reject_outliers;
+	bool lock_memory;
+	unsigned jobs;
+	std::vector<int> cpus;
+	unsigned reserved_cores;
+	bool idle_smt_siblings;
+	double time_budget_ns;
+	bool measure_memory;
+	std::uint64_t seed;
+
+	BenchmarkConfig(std::size_t num_trials):
+		warmup_runs(1),
+		min_trials(num_trials),
+		max_trials(10 * num_trials),
+		target_ci(0.02),
+		reject_outliers(true),
+		lock_memory(false),
+		jobs(1),
+		reserved_cores(0),
+		idle_smt_siblings(false),
+		time_budget_ns(0),
+		measure_memory(true),
+		seed(0) {}
+};
+
+/**
+ * Measurements of one algorithm on one dataset of one size. ops and hw are
+ * averages over the timed trials. predicted_ns is the time of one run
+ * predicted before measuring, 0 when too few sizes were measured yet. A
+ * REDUCED cell was measured with fewer trials than asked for, and a SKIPPED
+ * one not at all, to stay within the time budget. peak_memory is the most
+ * heap memory in bytes the sort allocated, if memory_measured, see
+ * BenchmarkConfig::measure_memory.
+ */
+struct CellResult {
+	enum Status { MEASURED, REDUCED, SKIPPED };
+
+	TimingStats time;
+	OpCounter ops;
+	HardwareCounters hw;
+	Status status;
+	double predicted_ns;
+	std::size_t peak_memory;
+	bool memory_measured;
+
+	CellResult():
+		status(MEASURED),
+		predicted_ns(0),
+		peak_memory(0),
+		memory_measured(false) {}
+};
+
+// Everything below is templated on the value type T being sorted, one of
+// the types of value_types.h. benchmark.cpp instantiates it for each of them.
+
+/**
+ * Measures one cell: sorts working, restored from data before every run,
+ * as often as config asks for. Each registered algorithm has its own
+ * instantiation with the sort compiled in, so the timed region makes a
+ * direct call that the compiler is free to inline.
+ */
+template <typename T>
+using CellRunner = CellResult (*)(std::vector<T> const &data, std::vector<T> &working, BenchmarkConfig const &config);
+
+/**
+ * Fills data, already sized, with the input of a dataset. The same seed
+ * gives the same input, whatever the number of threads generating it, and
+ * the same keys for every value type.
+ */
+template <typename T>
+using DatasetGenerator = void (*)(std::vector<T> &data, std::uint64_t seed);
+
+/**
+ * multithreaded marks algorithms that start threads of their own. The
+ * parallel scheduler runs their cells by themselves after all other cells,
+ * on every CPU, instead of on a single pinned worker. Cells of sizes above
+ * max_size, unless 0, are skipped, for algorithms that only do their own
+ * work on small inputs.
+ */
+template <typename T>
+struct Algorithm {
+	char const *name;
+	CellRunner<T> run;
+	bool multithreaded;
+	std::size_t max_size;
 };
 
-struct BenchmarkResults {
-	RuntimeRecord insertion_sort;
-	RuntimeRecord selection_sort;
-	RuntimeRecord bubble_sort;
-	RuntimeRecord merge_sort;
-	RuntimeRecord quick_sort;
-	RuntimeRecord hoare_quick_sort;
-	RuntimeRecord randomized_quick_sort;
-	RuntimeRecord heap_sort;
+template <typename T>
+struct Dataset {
+	char const *name;
+	DatasetGenerator<T> generate;
 };
 
-BenchmarkResults benchmark(std::size_t input_size, std::size_t num_trials);
+/**
+ * Returns every algorithm and dataset known to the benchmark for values of
+ * type T, in a fixed order. Both lists are static tables in benchmark.cpp;
+ * adding an algorithm or dataset means adding one line there. Algorithms
+ * that cannot sort T, such as radix sort on strings, are left out.
+ */
+template <typename T>
+std::vector<Algorithm<T>> const &registered_algorithms();
+
+template <typename T>
+std::vector<Dataset<T>> const &registered_datasets();
+
+/**
+ * Returns the entries of registry named in the comma-separated list names,
+ * in registry order, or all of them when names is empty. Names that match
+ * no entry are appended to unknown.
+ */
+template <typename Entry>
+std::vector<Entry> filter_by_name(std::vector<Entry> const &registry, std::string const &names, std::vector<std::string> &unknown)
+{
+	if (names.empty()) return registry;
+
+	std::vector<std::string> wanted;
+	std::string::size_type start = 0;
+	while (start <= names.size()) {
+		std::string::size_type comma = names.find(',', start);
+		if (comma == std::string::npos) comma = names.size();
+		if (comma > start) wanted.push_back(names.substr(start, comma - start));
+		start = comma + 1;
+	}
+
+	std::vector<Entry> selected;
+	for (auto const &entry : registry) {
+		for (auto const &name : wanted) {
+			if (name == entry.name) {
+				selected.push_back(entry);
+				break;
+			}
+		}
+	}
+	for (auto const &name : wanted) {
+		bool found = false;
+		for (auto const &entry : registry) found = found || name == entry.name;
+		if (!found) unknown.push_back(name);
+	}
+	return selected;
+}
+
+/**
+ * Results of a sweep over values of type T, indexed by algorithm, dataset
+ * and input size. Sizes are added as they are benchmarked and keep their
+ * order.
+ */
+template <typename T>
+class ResultTable {
+public:
+	ResultTable(std::vector<Algorithm<T>> const &algorithms, std::vector<Dataset<T>> const &datasets):
+		algorithm_list(algorithms),
+		dataset_list(datasets) {}
+
+	std::vector<Algorithm<T>> const &algorithms() const { return algorithm_list; }
+	std::vector<Dataset<T>> const &datasets() const { return dataset_list; }
+	std::vector<std::size_t> const &sizes() const { return size_list; }
+
+	/**
+	 * Adds a row of empty cells for input_size and returns its size index.
+	 */
+	std::size_t add_size(std::size_t input_size) {
+		size_list.push_back(input_size);
+		cells.resize(cells.size() + algorithm_list.size() * dataset_list.size());
+		return size_list.size() - 1;
+	}
+
+	CellResult &at(std::size_t algorithm, std::size_t dataset, std::size_t size_index) {
+		return cells[index(algorithm, dataset, size_index)];
+	}
+
+	CellResult const &at(std::size_t algorithm, std::size_t dataset, std::size_t size_index) const {
+		return cells[index(algorithm, dataset, size_index)];
+	}
+
+	/**
+	 * Returns whether every cell of a size was skipped, so no larger size
+	 * can be measured within the budget either.
+	 */
+	bool all_skipped(std::size_t size_index) const {
+		for (std::size_t a = 0; a < algorithm_list.size(); ++a)
+			for (std::size_t d = 0; d < dataset_list.size(); ++d)
+				if (at(a, d, size_index).status != CellResult::SKIPPED) return false;
+		return true;
+	}
+
+private:
+	std::size_t index(std::size_t algorithm, std::size_t dataset, std::size_t size_index) const {
+		return (size_index * algorithm_list.size() + algorithm) * dataset_list.size() + dataset;
+	}
+
+	std::vector<Algorithm<T>> algorithm_list;
+	std::vector<Dataset<T>> dataset_list;
+	std::vector<std::size_t> size_list;
+	std::vector<CellResult> cells;
+};
+
+/**
+ * Predicts the time of one run of cell (a, d) at the size of size_index
+ * from the median times measured at up to three earlier sizes, then
+ * decides how the cell is measured within config.time_budget_ns and marks
+ * it REDUCED or SKIPPED in table when it does not fit. Cells beyond the
+ * max_size of their algorithm are SKIPPED without a prediction. Returns
+ * the configuration to measure the cell with.
+ */
+template <typename T>
+BenchmarkConfig plan_cell(ResultTable<T> &table, std::size_t a, std::size_t d, std::size_t size_index, BenchmarkConfig const &config);
+
+/**
+ * Measures algorithm on dataset at input_size on its own, outside any
+ * table, the way benchmark() measures a cell but without a time budget.
+ * Analyses use it to probe sizes between those of a sweep.
+ */
+template <typename T>
+CellResult benchmark_cell(Algorithm<T> const &algorithm, Dataset<T> const &dataset, std::size_t input_size, BenchmarkConfig const &config);
+
+/**
+ * Returns the CPUs benchmark workers are pinned to under config, see
+ * BenchmarkConfig. Empty when CPU affinity is not supported.
+ */
+std::vector<int> benchmark_cpus(BenchmarkConfig const &config);
+
+/**
+ * Benchmarks every algorithm of table on every dataset of table at
+ * input_size, adding the results as a new size row. Cells are spread over
+ * config.jobs pinned workers, the most expensive first going by their
+ * predicted time, and measure the same work as when run one by one. Cells
+ * predicted to exceed config.time_budget_ns are reduced or skipped.
+ *
+ * @returns the size index of the new row.
+ */
+template <typename T>
+std::size_t benchmark(ResultTable<T> &table, std::size_t input_size, BenchmarkConfig const &config);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,80 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <atomic>
+
+// -----------------------------------------------------------
+// Operation counting policies
+//
+// Every algorithm in sort_algs.h takes a Counter &comp and reports through
+// four free functions, so a counter is any type these are overloaded for:
+//
+//   count_comparisons(c, n)  n key comparisons were made
+//   count_moves(c, n)        n elements were assigned, a swap being three
+//   counted_comparisons(c)   comparisons counted so far
+//   counted_moves(c)         moves counted so far
+// -----------------------------------------------------------
+
+/**
+ * Counts nothing. Every call inlines to nothing, so algorithms instantiated
+ * with NullCounter are as fast as uninstrumented code.
+ */
+struct NullCounter {};
+
+inline void count_comparisons(NullCounter &, unsigned long = 1) {}
+inline void count_moves(NullCounter &, unsigned long = 1) {}
+inline unsigned long counted_comparisons(NullCounter const &) { return 0; }
+inline unsigned long counted_moves(NullCounter const &) { return 0; }
+
+/**
+ * A bare unsigned long counts comparisons only, as every sort did before
+ * counting policies existed.
+ */
+inline void count_comparisons(unsigned long &c, unsigned long n = 1) { c += n; }
+inline void count_moves(unsigned long &, unsigned long = 1) {}
+inline unsigned long counted_comparisons(unsigned long const &c) { return c; }
+inline unsigned long counted_moves(unsigned long const &) { return 0; }
+
+/**
+ * Counts comparisons and element moves of a single thread.
+ */
+struct OpCounter {
+    unsigned long comparisons;
+    unsigned long moves;
+
+    OpCounter(): comparisons(0), moves(0) {}
+};
+
+inline void count_comparisons(OpCounter &c, unsigned long n = 1) { c.comparisons += n; }
+inline void count_moves(OpCounter &c, unsigned long n = 1) { c.moves += n; }
+inline unsigned long counted_comparisons(OpCounter const &c) { return c.comparisons; }
+inline unsigned long counted_moves(OpCounter const &c) { return c.moves; }
+
+/**
+ * Counts comparisons and element moves from any number of threads. Parallel
+ * sorts count into a per-thread counter and add it here once per task, so
+ * contention stays low even though every update is atomic.
+ */
+struct AtomicOpCounter {
+    std::atomic<unsigned long> comparisons;
+    std::atomic<unsigned long> moves;
+
+    AtomicOpCounter(): comparisons(0), moves(0) {}
+};
+
+inline void count_comparisons(AtomicOpCounter &c, unsigned long n = 1) { c.comparisons.fetch_add(n, std::memory_order_relaxed); }
+inline void count_moves(AtomicOpCounter &c, unsigned long n = 1) { c.moves.fetch_add(n, std::memory_order_relaxed); }
+inline unsigned long counted_comparisons(AtomicOpCounter const &c) { return c.comparisons.load(); }
+inline unsigned long counted_moves(AtomicOpCounter const &c) { return c.moves.load(); }
+
+/**
+ * Adds everything counted by from into to.
+ */
+template <typename To, typename From>
+void add_counts(To &to, From const &from)
+{
+    count_comparisons(to, counted_comparisons(from));
+    count_moves(to, counted_moves(from));
+}
+
+#endif
@@ -0,0 +1,644 @@
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "sort_algs.h"
+#include "random.h"
+#include "file_io.h"
+
+// -----------------------------------------------------------
+// External merge sort
+//
+// Sorts binary files of fixed-width values that are larger than memory.
+// The input is read in chunks that fit the memory budget, each chunk is
+// sorted in memory and spilled as a sorted run, and the runs are merged
+// through a tournament tree. When there are more runs than the budget has
+// room for read buffers, groups of runs are merged into longer runs first.
+//
+// Files hold the raw bytes of the values in native byte order. All I/O is
+// sequential, in blocks of at least ExternalSortConfig::block_size bytes,
+// and goes through AsyncIo, so the device works while the CPU sorts and
+// merges. mapped_sort sorts such a file in place through a memory mapping
+// instead.
+// -----------------------------------------------------------
+
+/**
+ * How an external sort may use memory and disk. memory_budget bounds the
+ * bytes of values held in memory at once, in chunks being sorted or in the
+ * I/O buffers of a merge. block_size is the smallest read or write worth
+ * its seek, which bounds how many runs one merge can take. Spilled runs go
+ * to unlinked files in temp_dir. asynchronous_io set to false makes every
+ * transfer block, for comparison with io_uring.
+ */
+struct ExternalSortConfig {
+    std::size_t memory_budget;
+    std::size_t block_size;
+    std::string temp_dir;
+    bool asynchronous_io;
+
+    ExternalSortConfig():
+        memory_budget(std::size_t(256) << 20),
+        block_size(std::size_t(256) << 10),
+        temp_dir("/tmp"),
+        asynchronous_io(true) {}
+};
+
+/**
+ * What an external sort did. error describes the failure when ok is false.
+ * runs counts the sorted runs spilled from the input, merge_passes the
+ * passes over all data merging them, the last one writing the output.
+ * asynchronous_io tells whether I/O overlapped the sort through io_uring.
+ */
+struct ExternalSortResult {
+    bool ok;
+    std::string error;
+    std::size_t runs;
+    std::size_t merge_passes;
+    std::uint64_t bytes_read;
+    std::uint64_t bytes_written;
+    bool asynchronous_io;
+
+    ExternalSortResult():
+        ok(false),
+        runs(0),
+        merge_passes(0),
+        bytes_read(0),
+        bytes_written(0),
+        asynchronous_io(false) {}
+};
+
+/**
+ * A sorted run: the values [begin, end) of a file, counted in values.
+ */
+struct Run {
+    std::uint64_t begin;
+    std::uint64_t end;
+};
+
+/**
+ * Reads the values of a run front to back through two buffers: while the
+ * merge consumes one, the next block of the run is read into the other.
+ */
+template <typename T>
+class RunReader {
+public:
+    RunReader(AsyncIo &io, File &file, Run const &run, std::size_t buffer_values):
+        io(&io),
+        file(&file),
+        next(run.begin),
+        end(run.end),
+        buffer(buffer_values),
+        prefetch_buffer(buffer_values),
+        position(0),
+        filled(0),
+        prefetched(0),
+        pending(false)
+    {
+        prefetch();
+        refill();
+    }
+
+    RunReader(RunReader &&other) noexcept:
+        io(other.io),
+        file(other.file),
+        next(other.next),
+        end(other.end),
+        buffer(std::move(other.buffer)),
+        prefetch_buffer(std::move(other.prefetch_buffer)),
+        position(other.position),
+        filled(other.filled),
+        prefetched(other.prefetched),
+        ticket(other.ticket),
+        pending(other.pending)
+    {
+        other.pending = false;
+    }
+
+    ~RunReader()
+    {
+        if (pending) io->wait(ticket);
+    }
+
+    bool empty() const { return position == filled; }
+    T const &front() const { return buffer[position]; }
+
+    void pop()
+    {
+        if (++position == filled) refill();
+    }
+
+private:
+    AsyncIo *io;
+    File *file;
+    std::uint64_t next;
+    std::uint64_t end;
+    std::vector<T> buffer;
+    std::vector<T> prefetch_buffer;
+    std::size_t position;
+    std::size_t filled;
+    std::size_t prefetched;
+    AsyncIo::Ticket ticket;
+    bool pending;
+
+    /**
+     * Starts reading the next block of the run into prefetch_buffer.
+     */
+    void prefetch()
+    {
+        prefetched = static_cast<std::size_t>(std::min<std::uint64_t>(prefetch_buffer.size(), end - next));
+        if (prefetched == 0) return;
+        ticket = io->read(*file, prefetch_buffer.data(), prefetched * sizeof(T), next * sizeof(T));
+        pending = true;
+        next += prefetched;
+    }
+
+    void refill()
+    {
+        position = filled = 0;
+        if (!pending) return;
+        io->wait(ticket);
+        pending = false;
+        if (!file->good()) return;
+        buffer.swap(prefetch_buffer);
+        filled = prefetched;
+        prefetch();
+    }
+};
+
+/**
+ * Collects values in one of two buffers and writes them to a file a block
+ * at a time, starting at the value offset it was created with. A full
+ * buffer is written while the other fills.
+ */
+template <typename T>
+class RunWriter {
+public:
+    RunWriter(AsyncIo &io, File &file, std::uint64_t offset, std::size_t buffer_values):
+        io(&io),
+        file(&file),
+        next(offset),
+        pending(false)
+    {
+        buffer.reserve(buffer_values);
+        write_buffer.reserve(buffer_values);
+    }
+
+    RunWriter(RunWriter const &) = delete;
+    RunWriter &operator=(RunWriter const &) = delete;
+
+    ~RunWriter()
+    {
+        if (pending) io->wait(ticket);
+    }
+
+    void push(T const &value)
+    {
+        buffer.push_back(value);
+        if (buffer.size() == buffer.capacity()) write();
+    }
+
+    /**
+     * Writes the values buffered so far, waits until every write is done,
+     * and returns the value offset the next one will be written at.
+     */
+    std::uint64_t flush()
+    {
+        if (!buffer.empty()) write();
+        if (pending) io->wait(ticket);
+        pending = false;
+        return next;
+    }
+
+private:
+    AsyncIo *io;
+    File *file;
+    std::uint64_t next;
+    std::vector<T> buffer;
+    std::vector<T> write_buffer;
+    AsyncIo::Ticket ticket;
+    bool pending;
+
+    void write()
+    {
+        if (pending) io->wait(ticket);
+        buffer.swap(write_buffer);
+        ticket = io->write(*file, write_buffer.data(), write_buffer.size() * sizeof(T), next * sizeof(T));
+        pending = true;
+        next += write_buffer.size();
+        buffer.clear();
+    }
+};
+
+/**
+ * A tournament tree of losers over k sorted sources, each a type with
+ * empty(), front() and pop(). The source with the smallest front wins;
+ * after it is popped only the path from its leaf to the root is replayed,
+ * so each value merged costs about log2(k) comparisons rather than the k
+ * of a linear scan. An empty source loses to every other.
+ */
+template <typename Source, typename Counter>
+class TournamentTree {
+public:
+    TournamentTree(std::vector<Source> &sources, Counter &comp):
+        sources(sources),
+        comp(comp),
+        losers(sources.size())
+    {
+        const std::size_t k = sources.size();
+        // winners[k + i] is leaf i, winners[1] the root
+        std::vector<std::size_t> winners(2 * k);
+        for (std::size_t i = 0; i < k; ++i) winners[k + i] = i;
+        for (std::size_t node = k - 1; node > 0; --node)
+        {
+            const std::size_t a = winners[2 * node], b = winners[2 * node + 1];
+            const bool a_wins = beats(a, b);
+            winners[node] = a_wins ? a : b;
+            losers[node] = a_wins ? b : a;
+        }
+        losers[0] = k > 1 ? winners[1] : 0;
+    }
+
+    bool empty() const { return sources[losers[0]].empty(); }
+    Source &winner() { return sources[losers[0]]; }
+
+    /**
+     * Pops the front of the winning source and finds the next winner.
+     */
+    void pop()
+    {
+        std::size_t winner = losers[0];
+        sources[winner].pop();
+        for (std::size_t node = (winner + sources.size()) / 2; node > 0; node /= 2)
+        {
+            if (beats(losers[node], winner)) std::swap(losers[node], winner);
+        }
+        losers[0] = winner;
+    }
+
+private:
+    std::vector<Source> &sources;
+    Counter &comp;
+    // losers[node] lost the match at node, losers[0] won the tournament
+    std::vector<std::size_t> losers;
+
+    bool beats(std::size_t a, std::size_t b)
+    {
+        if (sources[a].empty()) return false;
+        if (sources[b].empty()) return true;
+        count_comparisons(comp);
+        return !(sources[b].front() < sources[a].front());
+    }
+};
+
+/**
+ * Sorts a chunk in memory with the fastest engine for its type: radix sort
+ * for integers, block quick sort for everything else.
+ */
+template <typename T, typename Counter>
+void sort_chunk(std::vector<T> &chunk, Counter &comp, std::true_type)
+{
+    lsd_radix_sort(chunk.begin(), chunk.end(), comp);
+}
+
+template <typename T, typename Counter>
+void sort_chunk(std::vector<T> &chunk, Counter &comp, std::false_type)
+{
+    block_quick_sort(chunk.begin(), chunk.end(), comp);
+}
+
+/**
+ * Merges the runs [first, last) of src into one run of dst starting at
+ * value offset at, with two buffers of buffer_values values per run and
+ * for the output. Returns the value offset after the merged run.
+ */
+template <typename T, typename Counter>
+std::uint64_t merge_runs(AsyncIo &io, File &src, Run const *first, Run const *last, File &dst, std::uint64_t at,
+                         std::size_t buffer_values, Counter &comp)
+{
+    std::vector<RunReader<T>> readers;
+    readers.reserve(last - first);
+    for (Run const *run = first; run != last; ++run) readers.emplace_back(io, src, *run, buffer_values);
+
+    RunWriter<T> writer(io, dst, at, buffer_values);
+    TournamentTree<RunReader<T>, Counter> tree(readers, comp);
+    std::uint64_t merged = 0;
+    for (; !tree.empty(); tree.pop(), ++merged) writer.push(tree.winner().front());
+    count_moves(comp, merged);
+    return writer.flush();
+}
+
+/**
+ * Sorts the file at input_path of values of type T in ascending order into
+ * the file at output_path, which may be the same file, holding no more than
+ * config.memory_budget bytes of values in memory at once.
+ *
+ * Run formation reads the input a chunk at a time and spills each sorted
+ * chunk as a run. With asynchronous I/O it cycles through three chunks, so
+ * that sorting chunk k overlaps reading chunk k + 1 and writing run k - 1;
+ * with blocking I/O it sorts one chunk, the largest the budget allows, and
+ * asks the kernel to read the next one ahead meanwhile. The merge gives
+ * every run and the output one equal share of the budget as two I/O
+ * buffers, at least a block each, and reads the next block of every run
+ * while the current one is merged. When the budget cannot hold that many
+ * blocks, merge passes combine as many runs as it can until few enough
+ * remain. comp counts the comparisons and moves of sorting and merging.
+ *
+ * T must be trivially copyable. A file with a size that is not a multiple
+ * of sizeof(T) is rejected.
+ */
+template <typename T, typename Counter>
+ExternalSortResult external_sort(std::string const &input_path, std::string const &output_path,
+                                 ExternalSortConfig const &config, Counter &comp)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "external_sort requires a trivially copyable value type");
+
+    ExternalSortResult result;
+    File input;
+    if (!input.open_for_reading(input_path))
+    {
+        result.error = input.error();
+        return result;
+    }
+    const std::uint64_t bytes = input.size();
+    if (!input.good() || bytes % sizeof(T) != 0)
+    {
+        result.error = input.good() ? input_path + " does not hold a whole number of values" : input.error();
+        return result;
+    }
+    const std::uint64_t size = bytes / sizeof(T);
+    input.advise_sequential();
+
+    // A merge needs two blocks for each of at least two runs and the output
+    const std::size_t budget_values = std::max<std::size_t>(config.memory_budget / sizeof(T), 6);
+    const std::size_t block_values = std::max<std::size_t>(std::min(config.block_size / sizeof(T), budget_values / 6), 1);
+    const std::size_t fan_in = std::max<std::size_t>(budget_values / (2 * block_values) - 1, 2);
+
+    // Declared first, so that the files outlive every transfer
+    File spill, spare, output;
+    AsyncIo io(fan_in + 8, config.asynchronous_io);
+    result.asynchronous_io = io.asynchronous();
+
+    // Radix sort needs a scratch buffer as large as the chunk
+    const std::size_t num_chunks = io.asynchronous() ? 3 : 1;
+    const std::size_t chunk_values = std::max<std::size_t>(budget_values / (num_chunks + (std::is_integral<T>::value ? 1 : 0)), 1);
+    const std::uint64_t runs_to_form = size == 0 ? 1 : (size + chunk_values - 1) / chunk_values;
+
+    // Run formation: a single chunk is sorted straight into the output,
+    // which is only created once the input has been read
+    if (runs_to_form > 1 && !spill.create_temporary(config.temp_dir))
+    {
+        result.error = spill.error();
+        return result;
+    }
+    File &target = runs_to_form > 1 ? spill : output;
+    std::vector<Run> runs;
+    {
+        std::vector<T> chunks[3];
+        AsyncIo::Ticket reads[3], writes[3];
+        bool reading[3] = {}, writing[3] = {};
+        auto settle = [&](std::size_t c) {
+            if (reading[c]) io.wait(reads[c]);
+            if (writing[c]) io.wait(writes[c]);
+            reading[c] = writing[c] = false;
+        };
+        auto start_read = [&](std::uint64_t k) {
+            const std::size_t c = k % num_chunks;
+            settle(c);
+            chunks[c].resize(static_cast<std::size_t>(std::min<std::uint64_t>(chunk_values, size - k * chunk_values)));
+            reads[c] = io.read(input, chunks[c].data(), chunks[c].size() * sizeof(T), k * chunk_values * sizeof(T));
+            reading[c] = true;
+        };
+
+        start_read(0);
+        for (std::uint64_t k = 0; k < runs_to_form; ++k)
+        {
+            const std::size_t c = k % num_chunks;
+            std::vector<T> &chunk = chunks[c];
+            settle(c);
+            if (!input.good()) break;
+
+            const bool last = k + 1 == runs_to_form;
+            if (!last && num_chunks > 1) start_read(k + 1);
+            else if (!last) input.read_ahead((k + 1) * chunk_values * sizeof(T), chunk_values * sizeof(T));
+
+            sort_chunk(chunk, comp, std::is_integral<T>());
+
+            if (runs_to_form == 1 && !output.create(output_path)) break;
+            const std::uint64_t begin = k * chunk_values;
+            writes[c] = io.write(target, chunk.data(), chunk.size() * sizeof(T), begin * sizeof(T));
+            writing[c] = true;
+            runs.push_back(Run{begin, begin + chunk.size()});
+
+            if (!last && num_chunks == 1) start_read(k + 1);
+            if (!target.good()) break;
+        }
+        for (std::size_t c = 0; c < num_chunks; ++c) settle(c);
+    }
+    result.runs = runs.size();
+
+    // Merge passes until one pass can merge every run into the output
+    while (spill.good() && input.good() && runs.size() > fan_in)
+    {
+        if (!spare.good() && !spare.create_temporary(config.temp_dir)) break;
+        std::vector<Run> merged;
+        std::uint64_t at = 0;
+        for (std::size_t i = 0; i < runs.size(); i += fan_in)
+        {
+            const std::size_t group = std::min(fan_in, runs.size() - i);
+            const std::uint64_t end = merge_runs<T>(io, spill, &runs[i], &runs[i] + group, spare, at, block_values, comp);
+            merged.push_back(Run{at, end});
+            at = end;
+        }
+        if (!spill.good() || !spare.good()) break;
+        spill.swap(spare);
+        runs.swap(merged);
+        ++result.merge_passes;
+    }
+
+    if (spill.good() && input.good() && !runs.empty())
+    {
+        // Every run and the output share what the budget holds
+        const std::size_t buffer_values = std::max(block_values, budget_values / (2 * (runs.size() + 1)));
+        input.close();
+        if (output.create(output_path))
+            merge_runs<T>(io, spill, runs.data(), runs.data() + runs.size(), output, 0, buffer_values, comp);
+        ++result.merge_passes;
+    }
+
+    for (File const *file : { &input, &spill, &spare, &output })
+    {
+        result.bytes_read += file->bytes_read();
+        result.bytes_written += file->bytes_written();
+        if (result.error.empty() && !file->error().empty()) result.error = file->error();
+    }
+    result.ok = result.error.empty();
+    return result;
+}
+
+template <typename T>
+ExternalSortResult external_sort(std::string const &input_path, std::string const &output_path,
+                                 ExternalSortConfig const &config)
+{
+    NullCounter comp;
+    return external_sort<T>(input_path, output_path, config, comp);
+}
+
+/**
+ * A sorted run held in memory, as a source of a TournamentTree.
+ */
+template <typename T>
+struct MemoryRun {
+    T const *next;
+    T const *end;
+
+    bool empty() const { return next == end; }
+    T const &front() const { return *next; }
+    void pop() { ++next; }
+};
+
+/**
+ * Copies the first bytes bytes of src over those of dst a block of
+ * block_bytes at a time, reading each block while the last one is written.
+ */
+inline void copy_file(AsyncIo &io, File &src, File &dst, std::uint64_t bytes, std::size_t block_bytes)
+{
+    std::vector<char> buffers[2];
+    AsyncIo::Ticket writes[2];
+    bool writing[2] = {};
+    for (std::uint64_t offset = 0, b = 0; offset < bytes && src.good() && dst.good(); offset += block_bytes, b ^= 1)
+    {
+        const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(block_bytes, bytes - offset));
+        if (writing[b]) io.wait(writes[b]);
+        buffers[b].resize(n);
+        io.wait(io.read(src, buffers[b].data(), n, offset));
+        writes[b] = io.write(dst, buffers[b].data(), n, offset);
+        writing[b] = true;
+    }
+    for (int b = 0; b < 2; ++b)
+        if (writing[b]) io.wait(writes[b]);
+}
+
+/**
+ * Sorts the file at path of values of type T in ascending order in place
+ * through a memory mapping, sparing the copy into a vector and back.
+ *
+ * A file that fits config.memory_budget is read ahead as a whole and sorted
+ * by block_quick_sort on the mapping. A larger file is sorted one segment
+ * of the budget's size at a time: each segment is read ahead, sorted, its
+ * writeback started and its pages released, so that the page cache only
+ * ever has to hold about one segment for this process. The sorted segments
+ * are then merged through a tournament tree, read sequentially from the
+ * mapping, into a temporary file that is copied back over the original; a
+ * k-way merge cannot run in place. Either way msync writes the file back
+ * before returning. The mapping asks for transparent huge pages, which
+ * file systems that do not support them ignore.
+ *
+ * bytes_read and bytes_written of the result count the explicit transfers
+ * of the merge, not the page faults of the mapping.
+ */
+template <typename T, typename Counter>
+ExternalSortResult mapped_sort(std::string const &path, ExternalSortConfig const &config, Counter &comp)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "mapped_sort requires a trivially copyable value type");
+
+    ExternalSortResult result;
+    MappedFile mapping;
+    if (!mapping.map(path) || mapping.size() % sizeof(T) != 0)
+    {
+        result.error = mapping.good() ? path + " does not hold a whole number of values" : mapping.error();
+        return result;
+    }
+    T *values = static_cast<T *>(mapping.data());
+    const std::size_t size = mapping.size() / sizeof(T);
+    const std::size_t segment_values = std::max<std::size_t>(config.memory_budget / sizeof(T), 1);
+    mapping.advise(0, mapping.size(), MappedFile::HUGE_PAGES);
+
+    if (size <= segment_values)
+    {
+        mapping.advise(0, mapping.size(), MappedFile::WILL_NEED);
+        block_quick_sort(values, values + size, comp);
+        result.runs = 1;
+    }
+    else
+    {
+        std::vector<MemoryRun<T>> runs;
+        for (std::size_t begin = 0; begin < size; begin += segment_values)
+        {
+            const std::size_t end = std::min(size, begin + segment_values);
+            const std::size_t offset = begin * sizeof(T), bytes = (end - begin) * sizeof(T);
+            mapping.advise(offset, bytes, MappedFile::WILL_NEED);
+            block_quick_sort(values + begin, values + end, comp);
+            mapping.sync(offset, bytes, false);
+            mapping.advise(offset, bytes, MappedFile::DONT_NEED);
+            runs.push_back(MemoryRun<T>{values + begin, values + end});
+        }
+        result.runs = runs.size();
+
+        File spill;
+        AsyncIo io(8, config.asynchronous_io);
+        result.asynchronous_io = io.asynchronous();
+        const std::size_t block_values = std::max<std::size_t>(config.block_size / sizeof(T), 1);
+        if (spill.create_temporary(config.temp_dir))
+        {
+            mapping.advise(0, mapping.size(), MappedFile::SEQUENTIAL);
+            RunWriter<T> writer(io, spill, 0, block_values);
+            TournamentTree<MemoryRun<T>, Counter> tree(runs, comp);
+            std::uint64_t merged = 0;
+            for (; !tree.empty(); tree.pop(), ++merged) writer.push(tree.winner().front());
+            count_moves(comp, merged);
+            writer.flush();
+            ++result.merge_passes;
+        }
+        copy_file(io, spill, mapping.underlying(), mapping.size(), block_values * sizeof(T));
+
+        result.bytes_read = spill.bytes_read() + mapping.underlying().bytes_read();
+        result.bytes_written = spill.bytes_written() + mapping.underlying().bytes_written();
+        result.error = spill.error();
+    }
+
+    mapping.sync(0, mapping.size(), true);
+    if (result.error.empty()) result.error = mapping.error();
+    result.ok = result.error.empty();
+    return result;
+}
+
+template <typename T>
+ExternalSortResult mapped_sort(std::string const &path, ExternalSortConfig const &config)
+{
+    NullCounter comp;
+    return mapped_sort<T>(path, config, comp);
+}
+
+/**
+ * Writes count uniformly random values of integral type T to the file at
+ * path, the same values for the same seed, a block of block_size bytes at
+ * a time. Returns false with a message in error on failure.
+ */
+template <typename T>
+bool write_random_file(std::string const &path, std::uint64_t count, std::uint64_t seed,
+                       std::size_t block_size, std::string &error)
+{
+    static_assert(std::is_integral<T>::value, "write_random_file requires an integral value type");
+
+    File file;
+    Xoshiro256 rng(seed);
+    std::vector<T> block(std::max<std::size_t>(block_size / sizeof(T), 1));
+    if (file.create(path))
+    {
+        for (std::uint64_t at = 0; at < count && file.good(); at += block.size())
+        {
+            const std::size_t values = static_cast<std::size_t>(std::min<std::uint64_t>(block.size(), count - at));
+            for (std::size_t i = 0; i < values; ++i) block[i] = static_cast<T>(rng());
+            file.write_at(block.data(), values * sizeof(T), at * sizeof(T));
+        }
+    }
+    error = file.error();
+    return error.empty();
+}
+
+#endif
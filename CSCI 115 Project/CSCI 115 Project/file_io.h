@@ -0,0 +1,614 @@
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#   define FILE_IO_HAVE_POSIX 1
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#else
+#   define FILE_IO_HAVE_POSIX 0
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#   if __has_include(<linux/io_uring.h>)
+#       define FILE_IO_HAVE_IO_URING 1
+#       include <linux/io_uring.h>
+#       include <sys/syscall.h>
+#   endif
+#endif
+#ifndef FILE_IO_HAVE_IO_URING
+#   define FILE_IO_HAVE_IO_URING 0
+#endif
+
+// -----------------------------------------------------------
+// File I/O for disk-backed sorting
+//
+// File reads and writes at explicit offsets and blocks until done. AsyncIo
+// queues reads and writes of Files and lets the caller compute while the
+// device works, through Linux io_uring where the kernel offers it and by
+// blocking on pread and pwrite everywhere else. MappedFile maps a file into
+// memory, so it can be sorted in place through iterators.
+// -----------------------------------------------------------
+
+/**
+ * A file read and written at explicit offsets, counting the bytes it
+ * transfers. Failures leave a message in error() rather than throwing, and
+ * every later operation on the file fails too.
+ */
+class File {
+public:
+    File(): fd(-1), read_bytes(0), written_bytes(0) {}
+
+    ~File() { close(); }
+
+    File(File const &) = delete;
+    File &operator=(File const &) = delete;
+
+    friend class AsyncIo;
+    friend class MappedFile;
+
+    bool open_for_reading(std::string const &path)
+    {
+        return open(path, READ_MODE);
+    }
+
+    /**
+     * Opens the existing file at path for reading and writing.
+     */
+    bool open_for_update(std::string const &path)
+    {
+        return open(path, UPDATE_MODE);
+    }
+
+    /**
+     * Creates the file at path, or empties it when it exists.
+     */
+    bool create(std::string const &path)
+    {
+        return open(path, CREATE_MODE);
+    }
+
+    /**
+     * Creates a scratch file in dir that is unlinked at once, so it is
+     * removed when closed, even if the program crashes.
+     */
+    bool create_temporary(std::string const &dir)
+    {
+#if FILE_IO_HAVE_POSIX
+        std::string path = dir + "/external_sort.XXXXXX";
+        fd = mkstemp(&path[0]);
+        if (fd < 0) return fail("cannot create a temporary file in " + dir);
+        unlink(path.c_str());
+        return true;
+#else
+        return fail("external sorting needs POSIX file I/O");
+#endif
+    }
+
+    void swap(File &other)
+    {
+        std::swap(fd, other.fd);
+        message.swap(other.message);
+        std::swap(read_bytes, other.read_bytes);
+        std::swap(written_bytes, other.written_bytes);
+    }
+
+    void close()
+    {
+#if FILE_IO_HAVE_POSIX
+        if (fd >= 0) ::close(fd);
+#endif
+        fd = -1;
+    }
+
+    bool good() const { return fd >= 0 && message.empty(); }
+    std::string const &error() const { return message; }
+    std::uint64_t bytes_read() const { return read_bytes; }
+    std::uint64_t bytes_written() const { return written_bytes; }
+
+    std::uint64_t size()
+    {
+#if FILE_IO_HAVE_POSIX
+        struct stat status;
+        if (good() && fstat(fd, &status) == 0) return static_cast<std::uint64_t>(status.st_size);
+#endif
+        fail("cannot determine the file size");
+        return 0;
+    }
+
+    /**
+     * Reads bytes bytes at offset into data, retrying short reads. Reading
+     * past the end of the file is an error.
+     */
+    bool read_at(void *data, std::size_t bytes, std::uint64_t offset)
+    {
+#if FILE_IO_HAVE_POSIX
+        char *p = static_cast<char *>(data);
+        while (good() && bytes > 0)
+        {
+            const ssize_t n = pread(fd, p, bytes, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return fail(n == 0 ? "unexpected end of file" : std::strerror(errno));
+            p += n;
+            bytes -= n;
+            offset += n;
+            read_bytes += n;
+        }
+#endif
+        return good();
+    }
+
+    bool write_at(void const *data, std::size_t bytes, std::uint64_t offset)
+    {
+#if FILE_IO_HAVE_POSIX
+        char const *p = static_cast<char const *>(data);
+        while (good() && bytes > 0)
+        {
+            const ssize_t n = pwrite(fd, p, bytes, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return fail(std::strerror(errno));
+            p += n;
+            bytes -= n;
+            offset += n;
+            written_bytes += n;
+        }
+#endif
+        return good();
+    }
+
+    /**
+     * Tells the kernel the file is read front to back, so it reads further
+     * ahead than it would by default.
+     */
+    void advise_sequential()
+    {
+#if FILE_IO_HAVE_POSIX && defined(POSIX_FADV_SEQUENTIAL)
+        if (fd >= 0) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    }
+
+    /**
+     * Asks the kernel to start reading [offset, offset + bytes) into the page
+     * cache now, so a later read_at of it does not wait for the device.
+     */
+    void read_ahead(std::uint64_t offset, std::uint64_t bytes)
+    {
+#if FILE_IO_HAVE_POSIX && defined(POSIX_FADV_WILLNEED)
+        if (fd >= 0 && bytes > 0) posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(bytes), POSIX_FADV_WILLNEED);
+#endif
+    }
+
+private:
+    int fd;
+    std::string message;
+    std::uint64_t read_bytes;
+    std::uint64_t written_bytes;
+
+    enum Mode { READ_MODE, CREATE_MODE, UPDATE_MODE };
+
+    bool open(std::string const &path, Mode mode)
+    {
+#if FILE_IO_HAVE_POSIX
+        static const int flags[] = { O_RDONLY, O_WRONLY | O_CREAT | O_TRUNC, O_RDWR };
+        fd = ::open(path.c_str(), flags[mode], 0644);
+        if (fd < 0) return fail("cannot open " + path + ": " + std::strerror(errno));
+        return true;
+#else
+        (void)mode;
+        return fail("cannot open " + path + ": external sorting needs POSIX file I/O");
+#endif
+    }
+
+    bool fail(std::string const &what)
+    {
+        if (message.empty()) message = what;
+        return false;
+    }
+};
+
+
+/**
+ * A file mapped into memory for reading and writing, shared with the page
+ * cache so that stores reach the file. The mapping is released, and the
+ * kernel writes it back in its own time, when the object is destroyed;
+ * sync() writes it back at once.
+ */
+class MappedFile {
+public:
+    /**
+     * What a range of the mapping will be used for, for advise().
+     */
+    enum Advice { NORMAL, SEQUENTIAL, WILL_NEED, DONT_NEED, HUGE_PAGES };
+
+    MappedFile(): address(nullptr), length(0) {}
+
+    ~MappedFile() { unmap(); }
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile &operator=(MappedFile const &) = delete;
+
+    /**
+     * Maps the whole existing file at path. An empty file maps to no
+     * memory at all.
+     */
+    bool map(std::string const &path)
+    {
+        if (!file.open_for_update(path)) return false;
+        length = static_cast<std::size_t>(file.size());
+        if (!file.good() || length == 0) return file.good();
+#if FILE_IO_HAVE_POSIX
+        void *mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd, 0);
+        if (mapped == MAP_FAILED) return file.fail("cannot map " + path + ": " + std::strerror(errno));
+        address = mapped;
+#endif
+        return true;
+    }
+
+    void *data() const { return address; }
+    std::size_t size() const { return length; }
+
+    /**
+     * The mapped file itself, for reading and writing it without the
+     * mapping. Both see the same page cache.
+     */
+    File &underlying() { return file; }
+
+    bool good() const { return file.good(); }
+    std::string const &error() const { return file.error(); }
+
+    /**
+     * Tells the kernel how [offset, offset + bytes) will be used, widened to
+     * whole pages. A hint the kernel does not know is ignored.
+     */
+    void advise(std::size_t offset, std::size_t bytes, Advice advice)
+    {
+#if FILE_IO_HAVE_POSIX
+        static const long page = sysconf(_SC_PAGESIZE);
+        if (address == nullptr || bytes == 0) return;
+        const std::size_t begin = offset / page * page;
+        const std::size_t end = std::min(length, offset + bytes);
+        int flag;
+        switch (advice)
+        {
+            case SEQUENTIAL: flag = MADV_SEQUENTIAL; break;
+            case WILL_NEED:  flag = MADV_WILLNEED; break;
+            case DONT_NEED:  flag = MADV_DONTNEED; break;
+#   if defined(MADV_HUGEPAGE)
+            case HUGE_PAGES: flag = MADV_HUGEPAGE; break;
+#   endif
+            default:         flag = MADV_NORMAL; break;
+        }
+        madvise(static_cast<char *>(address) + begin, end - begin, flag);
+#else
+        (void)offset, (void)bytes, (void)advice;
+#endif
+    }
+
+    /**
+     * Writes the dirty pages of [offset, offset + bytes) back to the file,
+     * waiting for the device when wait is set and only starting the
+     * writeback otherwise.
+     */
+    bool sync(std::size_t offset, std::size_t bytes, bool wait)
+    {
+#if FILE_IO_HAVE_POSIX
+        static const long page = sysconf(_SC_PAGESIZE);
+        if (address == nullptr || bytes == 0) return good();
+        const std::size_t begin = offset / page * page;
+        const std::size_t end = std::min(length, offset + bytes);
+        if (msync(static_cast<char *>(address) + begin, end - begin, wait ? MS_SYNC : MS_ASYNC) != 0)
+            return file.fail(std::string("msync failed: ") + std::strerror(errno));
+#else
+        (void)offset, (void)bytes, (void)wait;
+#endif
+        return good();
+    }
+
+    void unmap()
+    {
+#if FILE_IO_HAVE_POSIX
+        if (address != nullptr) munmap(address, length);
+#endif
+        address = nullptr;
+        length = 0;
+        file.close();
+    }
+
+private:
+    File file;
+    void *address;
+    std::size_t length;
+};
+
+/**
+ * Asynchronous reads and writes of Files. read() and write() queue a
+ * transfer and return a ticket at once; wait() blocks until the transfer
+ * of a ticket is done, after which its buffer may be reused. Every ticket
+ * must be waited for exactly once, and a buffer must stay alive until its
+ * ticket was.
+ *
+ * Transfers go through an io_uring submission queue when the kernel
+ * supports it. Otherwise, or when asynchronous I/O is not wanted, read()
+ * and write() transfer synchronously with pread and pwrite, and wait()
+ * returns at once, so callers are written once for both. Short transfers
+ * are resubmitted for the rest; a failed transfer is retried synchronously
+ * so that File records the error.
+ */
+class AsyncIo {
+public:
+    typedef std::size_t Ticket;
+
+    /**
+     * @param depth the most transfers in flight at once.
+     * @param asynchronous whether to try io_uring at all.
+     */
+    AsyncIo(std::size_t depth, bool asynchronous = true):
+        slots(std::max<std::size_t>(depth, 1)),
+        ring_fd(-1)
+    {
+        if (asynchronous) setup_ring();
+    }
+
+    ~AsyncIo()
+    {
+        wait_all();
+#if FILE_IO_HAVE_IO_URING
+        if (ring_fd < 0) return;
+        munmap(sqes, sqes_size);
+        if (cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+        munmap(sq_ring, sq_ring_size);
+        close(ring_fd);
+#endif
+    }
+
+    AsyncIo(AsyncIo const &) = delete;
+    AsyncIo &operator=(AsyncIo const &) = delete;
+
+    /**
+     * Returns whether transfers overlap the caller, through io_uring.
+     */
+    bool asynchronous() const { return ring_fd >= 0; }
+
+    Ticket read(File &file, void *data, std::size_t bytes, std::uint64_t offset)
+    {
+        return submit(false, file, static_cast<char *>(data), bytes, offset);
+    }
+
+    Ticket write(File &file, void const *data, std::size_t bytes, std::uint64_t offset)
+    {
+        return submit(true, file, static_cast<char *>(const_cast<void *>(data)), bytes, offset);
+    }
+
+    void wait(Ticket ticket)
+    {
+        while (slots[ticket].busy && !slots[ticket].done) reap(true);
+        slots[ticket].busy = false;
+    }
+
+    /**
+     * Waits for every transfer in flight, without freeing their tickets.
+     */
+    void wait_all()
+    {
+        for (;;)
+        {
+            bool pending = false;
+            for (auto const &slot : slots) pending = pending || (slot.busy && !slot.done);
+            if (!pending) return;
+            reap(true);
+        }
+    }
+
+private:
+    struct Slot {
+        bool busy;
+        bool done;
+        bool write;
+        File *file;
+        char *data;
+        std::size_t bytes;
+        std::uint64_t offset;
+
+        Slot(): busy(false), done(false), write(false), file(nullptr), data(nullptr), bytes(0), offset(0) {}
+    };
+
+    std::vector<Slot> slots;
+    int ring_fd;
+#if FILE_IO_HAVE_IO_URING
+    void *sq_ring;
+    void *cq_ring;
+    io_uring_sqe *sqes;
+    std::size_t sq_ring_size;
+    std::size_t cq_ring_size;
+    std::size_t sqes_size;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    io_uring_cqe *cqes;
+#endif
+
+    Ticket submit(bool write, File &file, char *data, std::size_t bytes, std::uint64_t offset)
+    {
+        Ticket ticket = 0;
+        while (ticket < slots.size() && slots[ticket].busy) ++ticket;
+        if (ticket == slots.size()) slots.push_back(Slot());
+
+        Slot &slot = slots[ticket];
+        slot.busy = true;
+        slot.done = false;
+        slot.write = write;
+        slot.file = &file;
+        slot.data = data;
+        slot.bytes = bytes;
+        slot.offset = offset;
+        enqueue(ticket);
+        return ticket;
+    }
+
+    /**
+     * Hands the rest of the transfer of ticket to the kernel, or does it
+     * synchronously without a ring, when the file has failed or when the
+     * ring cannot take it.
+     */
+    void enqueue(Ticket ticket)
+    {
+        Slot &slot = slots[ticket];
+        if (slot.bytes == 0 || !slot.file->good() || !push_sqe(ticket)) finish(slot);
+    }
+
+    /**
+     * Transfers what is left of slot with blocking calls, which retry
+     * interrupted and short transfers and record any error in the file.
+     */
+    static void finish(Slot &slot)
+    {
+        if (slot.bytes > 0)
+        {
+            if (slot.write) slot.file->write_at(slot.data, slot.bytes, slot.offset);
+            else slot.file->read_at(slot.data, slot.bytes, slot.offset);
+        }
+        slot.bytes = 0;
+        slot.done = true;
+    }
+
+    void complete(Ticket ticket, int result)
+    {
+        Slot &slot = slots[ticket];
+        if (result <= 0)
+        {
+            finish(slot);
+            return;
+        }
+        if (slot.write) slot.file->written_bytes += result;
+        else slot.file->read_bytes += result;
+        slot.data += result;
+        slot.bytes -= result;
+        slot.offset += result;
+        if (slot.bytes == 0) slot.done = true;
+        else enqueue(ticket);
+    }
+
+#if FILE_IO_HAVE_IO_URING
+    static int io_uring_setup(unsigned entries, io_uring_params *params)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    static int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    void setup_ring()
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        const int fd = io_uring_setup(static_cast<unsigned>(std::min<std::size_t>(slots.size(), 4096)), &params);
+        if (fd < 0) return;
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+        sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        cq_ring = single_mmap ? sq_ring
+            : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        void *entries = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || entries == MAP_FAILED)
+        {
+            if (entries != MAP_FAILED) munmap(entries, sqes_size);
+            if (cq_ring != MAP_FAILED && cq_ring != sq_ring) munmap(cq_ring, cq_ring_size);
+            if (sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+            close(fd);
+            return;
+        }
+
+        char *sq = static_cast<char *>(sq_ring), *cq = static_cast<char *>(cq_ring);
+        sqes = static_cast<io_uring_sqe *>(entries);
+        sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        ring_fd = fd;
+    }
+
+    /**
+     * Submits the rest of the transfer of ticket to the ring. Returns false
+     * when it cannot, so the caller transfers synchronously instead.
+     */
+    bool push_sqe(Ticket ticket)
+    {
+        if (ring_fd < 0) return false;
+        Slot const &slot = slots[ticket];
+
+        // The kernel consumes every entry during io_uring_enter below, so
+        // the queue always has room for the next one
+        const unsigned tail = *sq_tail;
+        const unsigned index = tail & *sq_mask;
+        io_uring_sqe &sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = slot.write ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe.fd = slot.file->fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(slot.data);
+        // Larger transfers complete short and are resubmitted for the rest
+        sqe.len = static_cast<unsigned>(std::min<std::size_t>(slot.bytes, 1u << 30));
+        sqe.off = slot.offset;
+        sqe.user_data = ticket;
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        int submitted;
+        while ((submitted = io_uring_enter(ring_fd, 1, 0, 0)) < 0 && errno == EINTR) {}
+        if (submitted == 1) return true;
+        // Take the entry back
+        __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+        return false;
+    }
+
+    /**
+     * Completes the transfers the kernel has finished, first waiting for at
+     * least one when block is set.
+     */
+    void reap(bool block)
+    {
+        if (ring_fd < 0) return;
+        unsigned head = *cq_head;
+        if (block && head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+        {
+            if (io_uring_enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) return;
+        }
+        for (; head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE); ++head)
+        {
+            io_uring_cqe const &cqe = cqes[head & *cq_mask];
+            const Ticket ticket = static_cast<Ticket>(cqe.user_data);
+            const int result = cqe.res;
+            __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+            complete(ticket, result);
+        }
+    }
+#else
+    void setup_ring() {}
+    bool push_sqe(Ticket) { return false; }
+    void reap(bool) {}
+#endif
+};
+
+#endif
@@ -1,13 +1,21 @@
 #include "sort_algs.h"
 #include "benchmark.h"
+#include "report.h"
+#include "analysis.h"
+#include "external_sort.h"
 #include <unordered_map>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
 #include <vector>
+#include <map>
+#include <memory>
+#include <iterator>
 #include <cstdlib>
 #include <ctime>
+#include <random>
+#include <chrono>
 
 //Part 2
 
@@ -112,175 +120,488 @@ bool hash_find(RandomAccessIterator begin, RandomAccessIterator end, T val) {
 #else
 
 constexpr std::size_t NUM_TRIALS = 10;
+constexpr std::size_t NUM_WARMUP_RUNS = 1;
+constexpr bool LOCK_MEMORY = false;
 constexpr std::size_t MAX_INPUT_SIZE = 65536;
+constexpr double CELL_TIME_BUDGET_SECONDS = 30;
+constexpr double REGRESSION_THRESHOLD_PERCENT = 5;
+constexpr std::size_t MAX_CROSSOVER_PROBES = 20;
+// Complexity fits ignore smaller sizes, dominated by call overheads
+constexpr double MIN_FIT_SIZE = 16;
+char const *const RESULTS_PATH = "benchmark_data/results.jsonl";
+constexpr std::size_t EXTERNAL_SORT_MEMORY_MIB = 256;
 
-int main() {
-	std::srand(std::time(nullptr));
+/**
+ * Writes value, or "skipped" for a cell that was not measured because it
+ * would have exceeded its time budget.
+ */
+template <typename Value>
+static void write_cell(std::ostream &csv, CellResult const &cell, Value value) {
+	csv << ",";
+	if (cell.status == CellResult::SKIPPED) csv << "skipped";
+	else csv << value;
+}
+
+/**
+ * Writes the header of the CSV file of one dataset: the median time in
+ * nanoseconds, then comparisons, then moves of every algorithm.
+ */
+template <typename T>
+static void write_dataset_header(std::ostream &csv, ResultTable<T> const &table) {
+	csv << "N";
+	for (auto const &algorithm : table.algorithms()) csv << "," << algorithm.name;
+	for (auto const &algorithm : table.algorithms()) csv << "," << algorithm.name << "_comp";
+	for (auto const &algorithm : table.algorithms()) csv << "," << algorithm.name << "_moves";
+	csv << "\n";
+}
+
+template <typename T>
+static void write_dataset_row(std::ostream &csv, ResultTable<T> const &table, std::size_t dataset, std::size_t size_index) {
+	const std::size_t num_algorithms = table.algorithms().size();
+
+	csv << table.sizes()[size_index];
+	for (std::size_t a = 0; a < num_algorithms; ++a) write_cell(csv, table.at(a, dataset, size_index), table.at(a, dataset, size_index).time.median);
+	for (std::size_t a = 0; a < num_algorithms; ++a) write_cell(csv, table.at(a, dataset, size_index), table.at(a, dataset, size_index).ops.comparisons);
+	for (std::size_t a = 0; a < num_algorithms; ++a) write_cell(csv, table.at(a, dataset, size_index), table.at(a, dataset, size_index).ops.moves);
+	csv << "\n";
+}
+
+/**
+ * Writes one row of timing statistics per algorithm and dataset of a size,
+ * with whether the cell was measured in full, with reduced trials or
+ * skipped, the time of one run predicted beforehand, and the peak heap
+ * memory the sort allocated, left empty when it was not measured.
+ */
+template <typename T>
+static void write_timing_stats(std::ostream &csv, ResultTable<T> const &table, std::size_t size_index) {
+	for (std::size_t a = 0; a < table.algorithms().size(); ++a) {
+		for (std::size_t d = 0; d < table.datasets().size(); ++d) {
+			CellResult const &cell = table.at(a, d, size_index);
+			TimingStats const &stats = cell.time;
+			csv << table.sizes()[size_index]   << ","
+			    << table.algorithms()[a].name  << ","
+			    << table.datasets()[d].name    << ","
+			    << cell_status_name(cell.status) << ","
+			    << cell.predicted_ns           << ","
+			    << stats.trials                << ","
+			    << stats.outliers              << ","
+			    << stats.min                   << ","
+			    << stats.median                << ","
+			    << stats.p90                   << ","
+			    << stats.p99                   << ","
+			    << stats.mean                  << ","
+			    << stats.stddev                << ","
+			    << stats.ns_per_element        << ","
+			    << stats.elements_per_second   << ",";
+			if (cell.memory_measured) csv << cell.peak_memory;
+			csv << "\n";
+		}
+	}
+}
 
-	std::ofstream unsorted_csv(  "benchmark_data/unsorted.csv",            std::ofstream::out);
-	std::ofstream sorted_csv(    "benchmark_data/sorted.csv",              std::ofstream::out);
-	std::ofstream reverse_csv(   "benchmark_data/reverse_sorted.csv",      std::ofstream::out);
-	std::ofstream psorted25_csv( "benchmark_data/partially_sorted_25.csv", std::ofstream::out);
-	std::ofstream psorted50_csv( "benchmark_data/partially_sorted_50.csv", std::ofstream::out);
-	std::ofstream psorted75_csv( "benchmark_data/partially_sorted_75.csv", std::ofstream::out);
-	std::ofstream few_unique_csv("benchmark_data/few_unique_10.csv",       std::ofstream::out);
+/**
+ * Writes one row of hardware counters per algorithm and dataset of a size.
+ * Nothing is written when the counters were unavailable.
+ */
+template <typename T>
+static void write_hardware_counters(std::ostream &csv, ResultTable<T> const &table, std::size_t size_index) {
+	for (std::size_t a = 0; a < table.algorithms().size(); ++a) {
+		for (std::size_t d = 0; d < table.datasets().size(); ++d) {
+			HardwareCounters const &hw = table.at(a, d, size_index).hw;
+			if (!hw.valid) continue;
+			csv << table.sizes()[size_index]   << ","
+			    << table.algorithms()[a].name  << ","
+			    << table.datasets()[d].name    << ","
+			    << hw.cycles                   << ","
+			    << hw.instructions             << ","
+			    << hw.branch_misses            << ","
+			    << hw.l1d_misses               << ","
+			    << hw.llc_misses               << ","
+			    << hw.dtlb_misses              << "\n";
+		}
+	}
+}
 
-	std::string headers = "N,insertion,selection,bubble,merge,quick,hoare-quick,randomized-quick,heap,insertion_comp,selection_comp,bubble_comp,merge_comp,quick_comp,hoare-quick_comp,randomized-quick_comp,heap_comp\n";
+/**
+ * Parses a CPU list such as "2-5,8" into its CPU numbers. Returns false on
+ * malformed input.
+ */
+static bool parse_cpu_list(std::string const &list, std::vector<int> &cpus) {
+	std::istringstream in(list);
+	std::string range;
+	while (std::getline(in, range, ',')) {
+		int first = 0, last = 0;
+		char dash = 0;
+		std::istringstream parts(range);
+		if (!(parts >> first)) return false;
+		last = first;
+		if (parts >> dash && (dash != '-' || !(parts >> last))) return false;
+		if (first < 0 || last < first) return false;
+		for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+	}
+	return !cpus.empty();
+}
+
+/**
+ * What a sweep measures: the names of the algorithms and datasets to run,
+ * empty for all of them, and how. Input sizes double from 1 up to
+ * max_input_size. With refine_crossovers, sizes between those are measured
+ * to find where one algorithm overtakes another.
+ */
+struct SweepOptions {
+	BenchmarkConfig config;
+	std::string algorithm_names;
+	std::string dataset_names;
+	std::size_t max_input_size;
+	std::ostream *results;
+	bool refine_crossovers;
 
-	unsorted_csv   << headers;
-	sorted_csv     << headers;
-	reverse_csv    << headers;
-	psorted25_csv  << headers;
-	psorted50_csv  << headers;
-	psorted75_csv  << headers;
-	few_unique_csv << headers;
+	SweepOptions(std::size_t num_trials):
+		config(num_trials),
+		max_input_size(MAX_INPUT_SIZE),
+		results(nullptr),
+		refine_crossovers(false) {}
+};
 
-	for (auto input_size = 1; input_size <= MAX_INPUT_SIZE; input_size *= 2) {
+/**
+ * Returns the path of a result file of the sweep over values of type T.
+ * Results for int keep the names they had before other types existed;
+ * every other type gets its name appended, as in unsorted_string.csv.
+ */
+template <typename T>
+static std::string result_path(std::string const &name) {
+	const std::string type = value_type_name<T>();
+	return "benchmark_data/" + name + (type == value_type_name<int>() ? "" : "_" + type) + ".csv";
+}
+
+/**
+ * Writes the crossovers of table to csv and prints them.
+ */
+template <typename T>
+static void write_crossovers(std::ostream &csv, ResultTable<T> const &table, std::vector<Crossover> const &crossovers) {
+	csv << "dataset,winner,loser,below,crossover,refined\n";
+	for (auto const &crossover : crossovers) {
+		char const *winner = table.algorithms()[crossover.winner].name;
+		char const *loser = table.algorithms()[crossover.loser].name;
+		char const *dataset = table.datasets()[crossover.dataset].name;
+		csv << dataset << "," << winner << "," << loser << "," << crossover.below << ","
+		    << crossover.crossover << "," << (crossover.refined ? 1 : 0) << "\n";
+		std::cout << dataset << ": " << winner << " beats " << loser << " from N=" << crossover.crossover
+		          << " (" << loser << " wins at N=" << crossover.below << ")" << std::endl;
+	}
+}
+
+/**
+ * Benchmarks sorting values of type T at every input size, writing the
+ * results of each size as soon as it is done, then fits complexity models
+ * to the results and finds the crossovers between algorithms.
+ */
+template <typename T>
+static void sweep(SweepOptions const &options) {
+	BenchmarkConfig const &config = options.config;
+
+	// Algorithms that cannot sort T, such as radix sort on strings, are
+	// quietly left out when named
+	std::vector<std::string> unsupported;
+	ResultTable<T> table(filter_by_name(registered_algorithms<T>(), options.algorithm_names, unsupported),
+	                     filter_by_name(registered_datasets<T>(), options.dataset_names, unsupported));
+	if (table.algorithms().empty()) return;
+
+	std::vector<std::unique_ptr<std::ofstream>> dataset_csvs;
+	for (auto const &dataset : table.datasets()) {
+		dataset_csvs.emplace_back(new std::ofstream(result_path<T>(dataset.name), std::ofstream::out));
+		write_dataset_header(*dataset_csvs.back(), table);
+	}
+	std::ofstream stats_csv(   result_path<T>("timing_stats"),      std::ofstream::out);
+	std::ofstream hardware_csv(result_path<T>("hardware_counters"), std::ofstream::out);
+	stats_csv    << "N,algorithm,dataset,status,predicted_ns,trials,outliers,min_ns,median_ns,p90_ns,p99_ns,mean_ns,stddev_ns,ns_per_element,elements_per_second,peak_memory_bytes\n";
+	hardware_csv << "N,algorithm,dataset,cycles,instructions,branch_misses,l1d_misses,llc_misses,dtlb_misses\n";
+
+	for (std::size_t input_size = 1; input_size <= options.max_input_size; input_size *= 2) {
 		std::cout << "------------------------------------------------------------" << std::endl;
-		std::cout << "Input size = " << input_size << ", # trials = " << NUM_TRIALS << std::endl;
+		std::cout << "Type = " << value_type_name<T>() << " (" << sizeof(T) << " bytes), input size = " << input_size
+		          << ", # trials = " << config.min_trials << "-" << config.max_trials << std::endl;
 		std::cout << "------------------------------------------------------------" << std::endl;
-		
-		BenchmarkResults results = benchmark(input_size, NUM_TRIALS);
-		
-		unsorted_csv << input_size                                     << ","
-				     << results.insertion_sort.unsorted.count()        << ","
-		 		     << results.selection_sort.unsorted.count()        << ","
-				     << results.bubble_sort.unsorted.count()           << ","
-				     << results.merge_sort.unsorted.count()            << ","
-				     << results.quick_sort.unsorted.count()            << ","
-					 << results.hoare_quick_sort.unsorted.count()      << ","
-					 << results.randomized_quick_sort.unsorted.count() << ","      
-				     << results.heap_sort.unsorted.count()             << ","
-					 << results.insertion_sort.unsorted_count          << ","
-		 		     << results.selection_sort.unsorted_count          << ","
-				     << results.bubble_sort.unsorted_count             << ","
-				     << results.merge_sort.unsorted_count              << ","
-				     << results.quick_sort.unsorted_count              << ","
-					 << results.hoare_quick_sort.unsorted_count        << ","
-					 << results.randomized_quick_sort.unsorted_count   << ","      
-				     << results.heap_sort.unsorted_count               << "\n";
-
-		
-		sorted_csv << input_size                                   << ","
-		           << results.insertion_sort.sorted.count()        << ","
-		 		   << results.selection_sort.sorted.count()        << ","
-				   << results.bubble_sort.sorted.count()           << ","
-				   << results.merge_sort.sorted.count()            << ","
-				   << results.quick_sort.sorted.count()            << ","
-				   << results.hoare_quick_sort.sorted.count()      << ","
-				   << results.randomized_quick_sort.sorted.count() << ","   
-				   << results.heap_sort.sorted.count()             << ","
-				   << results.insertion_sort.sorted_count          << ","
-		 		   << results.selection_sort.sorted_count          << ","
-				   << results.bubble_sort.sorted_count             << ","
-				   << results.merge_sort.sorted_count              << ","
-				   << results.quick_sort.sorted_count              << ","
-				   << results.hoare_quick_sort.sorted_count        << ","
-				   << results.randomized_quick_sort.sorted_count   << ","   
-				   << results.heap_sort.sorted_count               << "\n";
-
-		reverse_csv << input_size                                    << ","
-		            << results.insertion_sort.rsorted.count()        << ","
-		 		    << results.selection_sort.rsorted.count()        << ","
-				    << results.bubble_sort.rsorted.count()           << ","
-				    << results.merge_sort.rsorted.count()            << ","
-				    << results.quick_sort.rsorted.count()            << ","
-					<< results.hoare_quick_sort.rsorted.count()      << ","
-					<< results.randomized_quick_sort.rsorted.count() << ","   
-				    << results.heap_sort.rsorted.count()             << ","
-					<< results.insertion_sort.rsorted_count          << ","
-		 		    << results.selection_sort.rsorted_count          << ","
-				    << results.bubble_sort.rsorted_count             << ","
-				    << results.merge_sort.rsorted_count              << ","
-				    << results.quick_sort.rsorted_count              << ","
-					<< results.hoare_quick_sort.rsorted_count        << ","
-					<< results.randomized_quick_sort.rsorted_count   << ","   
-				    << results.heap_sort.rsorted_count               << "\n";
-
-		psorted25_csv << input_size                                       << ","
-		              << results.insertion_sort.psorted_25.count()        << ","
-		 		      << results.selection_sort.psorted_25.count()        << ","
-				      << results.bubble_sort.psorted_25.count()           << ","
-				      << results.merge_sort.psorted_25.count()            << ","
-				      << results.quick_sort.psorted_25.count()            << ","
-					  << results.hoare_quick_sort.psorted_25.count()      << ","
-					  << results.randomized_quick_sort.psorted_25.count() << ","   
-				      << results.heap_sort.psorted_25.count()             << ","
-					  << results.insertion_sort.psorted_25_count          << ","
-		 		      << results.selection_sort.psorted_25_count          << ","
-				      << results.bubble_sort.psorted_25_count             << ","
-				      << results.merge_sort.psorted_25_count              << ","
-				      << results.quick_sort.psorted_25_count              << ","
-					  << results.hoare_quick_sort.psorted_25_count        << ","
-					  << results.randomized_quick_sort.psorted_25_count   << ","   
-				      << results.heap_sort.psorted_25_count               << "\n";
-
-		psorted50_csv << input_size                                       << ","
-		              << results.insertion_sort.psorted_50.count()        << ","
-		 		      << results.selection_sort.psorted_50.count()        << ","
-				      << results.bubble_sort.psorted_50.count()           << ","
-				      << results.merge_sort.psorted_50.count()            << ","
-				      << results.quick_sort.psorted_50.count()            << ","
-					  << results.hoare_quick_sort.psorted_50.count()      << ","
-					  << results.randomized_quick_sort.psorted_50.count() << ","   
-				      << results.heap_sort.psorted_50.count()             << ","
-					  << results.insertion_sort.psorted_50_count          << ","
-		 		      << results.selection_sort.psorted_50_count          << ","
-				      << results.bubble_sort.psorted_50_count             << ","
-				      << results.merge_sort.psorted_50_count              << ","
-				      << results.quick_sort.psorted_50_count              << ","
-					  << results.hoare_quick_sort.psorted_50_count        << ","
-					  << results.randomized_quick_sort.psorted_50_count   << ","   
-				      << results.heap_sort.psorted_50_count               << "\n";
-
-		psorted75_csv << input_size                                       << ","
-		              << results.insertion_sort.psorted_75.count()        << ","
-		 		      << results.selection_sort.psorted_75.count()        << ","
-				      << results.bubble_sort.psorted_75.count()           << ","
-				      << results.merge_sort.psorted_75.count()            << ","
-				      << results.quick_sort.psorted_75.count()            << ","
-					  << results.hoare_quick_sort.psorted_75.count()      << ","
-					  << results.randomized_quick_sort.psorted_75.count() << ","   
-				      << results.heap_sort.psorted_75.count()             << ","
-					  << results.insertion_sort.psorted_75_count          << ","
-		 		      << results.selection_sort.psorted_75_count          << ","
-				      << results.bubble_sort.psorted_75_count             << ","
-				      << results.merge_sort.psorted_75_count              << ","
-				      << results.quick_sort.psorted_75_count              << ","
-					  << results.hoare_quick_sort.psorted_75_count        << ","
-					  << results.randomized_quick_sort.psorted_75_count   << ","   
-				      << results.heap_sort.psorted_75_count               << "\n";
-
-		few_unique_csv << input_size                                       << ","
-		               << results.insertion_sort.few_unique.count()        << ","
-		 		       << results.selection_sort.few_unique.count()        << ","
-				       << results.bubble_sort.few_unique.count()           << ","
-				       << results.merge_sort.few_unique.count()            << ","
-				       << results.quick_sort.few_unique.count()            << ","
-					   << results.hoare_quick_sort.few_unique.count()      << ","
-					   << results.randomized_quick_sort.few_unique.count() << ","   
-				       << results.heap_sort.few_unique.count()             << ","
-					   << results.insertion_sort.few_unique_count          << ","
-		 		       << results.selection_sort.few_unique_count          << ","
-				       << results.bubble_sort.few_unique_count             << ","
-				       << results.merge_sort.few_unique_count              << ","
-				       << results.quick_sort.few_unique_count              << ","
-					   << results.hoare_quick_sort.few_unique_count        << ","
-					   << results.randomized_quick_sort.few_unique_count   << ","   
-				       << results.heap_sort.few_unique_count               << "\n";
+
+		const std::size_t size_index = benchmark(table, input_size, config);
+
+		for (std::size_t d = 0; d < table.datasets().size(); ++d)
+			write_dataset_row(*dataset_csvs[d], table, d, size_index);
+		write_timing_stats(stats_csv, table, size_index);
+		write_hardware_counters(hardware_csv, table, size_index);
+		if (options.results) write_json_cells(*options.results, table, size_index);
 
 		std::cout << std::endl;
+		if (table.all_skipped(size_index)) {
+			std::cout << "Every cell exceeds the time budget at this size, stopping" << std::endl;
+			break;
+		}
+	}
+
+	std::ofstream complexity_csv(result_path<T>("complexity"), std::ofstream::out);
+	write_complexity_fits(complexity_csv, table, MIN_FIT_SIZE);
+
+	std::vector<Crossover> crossovers = find_crossovers(table);
+	if (crossovers.empty()) return;
+	std::cout << "------------------------------------------------------------" << std::endl;
+	std::cout << "Crossovers" << (options.refine_crossovers ? ", refining" : "") << std::endl;
+	std::cout << "------------------------------------------------------------" << std::endl;
+	if (options.refine_crossovers) {
+		for (auto &crossover : crossovers) refine_crossover(table, crossover, config, MAX_CROSSOVER_PROBES);
 	}
+	std::ofstream crossovers_csv(result_path<T>("crossovers"), std::ofstream::out);
+	write_crossovers(crossovers_csv, table, crossovers);
+}
 
-	unsorted_csv.close();
-	sorted_csv.close();
-	reverse_csv.close();
-	psorted25_csv.close();
-	psorted50_csv.close();
-	psorted75_csv.close();
-	few_unique_csv.close();
+struct ValueType {
+	char const *name;
+	void (*sweep)(SweepOptions const &options);
+};
 
+static const ValueType VALUE_TYPES[] = {
+	{ value_type_name<int>(),          sweep<int> },
+	{ value_type_name<std::int64_t>(), sweep<std::int64_t> },
+	{ value_type_name<double>(),       sweep<double> },
+	{ value_type_name<std::string>(),  sweep<std::string> },
+	{ value_type_name<Record<32>>(),   sweep<Record<32>> },
+	{ value_type_name<Record<64>>(),   sweep<Record<64>> },
+	{ value_type_name<Record<128>>(),  sweep<Record<128>> },
+};
+
+/**
+ * The cells and environment of a results file.
+ */
+struct Results {
+	std::string path;
+	std::vector<CellSummary> cells;
+	std::map<std::string, std::string> environment;
+};
+
+/**
+ * Reads the results file at path into results, printing an error and
+ * returning false when it cannot be read.
+ */
+static bool load_results(std::string const &path, Results &results) {
+	std::string error;
+	results.path = path;
+	if (read_results(path, results.cells, results.environment, error)) return true;
+	std::cerr << error << std::endl;
+	return false;
+}
+
+/**
+ * Compares the results candidate to baseline and prints the cells that
+ * changed. Returns the exit status: 2 when a cell became significantly
+ * slower by more than threshold and 0 otherwise.
+ */
+static int compare(Results &baseline, Results &candidate, double threshold) {
+	std::cout << "Baseline:  " << baseline.path << " (commit " << baseline.environment["commit"] << ", " << baseline.environment["timestamp"] << ")\n"
+	          << "Candidate: " << candidate.path << " (commit " << candidate.environment["commit"] << ", " << candidate.environment["timestamp"] << ")" << std::endl;
+	for (char const *key : { "cpu", "compiler", "flags" }) {
+		if (baseline.environment[key] != candidate.environment[key])
+			std::cout << "Warning: the runs differ in " << key << ": " << baseline.environment[key] << " vs " << candidate.environment[key] << std::endl;
+	}
+
+	return compare_results(baseline.cells, candidate.cells, threshold, std::cout) > 0 ? 2 : 0;
+}
+
+/**
+ * Splits "first,second" at its first comma into first and second, leaving
+ * second as it is when there is no comma.
+ */
+static void split_pair(std::string const &arg, std::string &first, std::string &second) {
+	const std::string::size_type comma = arg.find(',');
+	first = arg.substr(0, comma);
+	if (comma != std::string::npos) second = arg.substr(comma + 1);
+}
+
+/**
+ * Writes mib MiB of random 64-bit integers to the file at path for
+ * external sorting. Returns the exit status.
+ */
+static int generate_file(std::string const &path, std::uint64_t mib, std::uint64_t seed) {
+	std::string error;
+	const std::uint64_t count = (mib << 20) / sizeof(std::int64_t);
+	if (!write_random_file<std::int64_t>(path, count, seed, std::size_t(1) << 20, error)) {
+		std::cerr << error << std::endl;
+		return 1;
+	}
+	std::cout << "Wrote " << count << " random 64-bit integers to " << path << std::endl;
+	return 0;
+}
+
+/**
+ * Sorts the file of 64-bit integers at input_path into output_path with an
+ * external merge sort, or in place through a memory mapping when mapped is
+ * set, and prints what it did. Returns the exit status.
+ */
+static int sort_file(std::string const &input_path, std::string const &output_path, bool mapped, ExternalSortConfig const &config) {
+	const auto start = std::chrono::steady_clock::now();
+	OpCounter ops;
+	const ExternalSortResult result = mapped
+		? mapped_sort<std::int64_t>(input_path, config, ops)
+		: external_sort<std::int64_t>(input_path, output_path, config, ops);
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (!result.ok) {
+		std::cerr << "Sorting " << input_path << " failed: " << result.error << std::endl;
+		return 1;
+	}
+
+	const double mib = 1.0 / (1 << 20);
+	std::cout << "Sorted " << input_path << (mapped ? " in place" : " into " + output_path) << " in " << seconds << " s with "
+	          << (config.memory_budget >> 20) << " MiB of memory\n"
+	          << "  " << result.runs << " runs, " << result.merge_passes << " merge passes, "
+	          << ops.comparisons << " comparisons" << std::endl;
+	// A mapped sort that fits in memory transfers nothing but page faults
+	if (result.merge_passes > 0) {
+		std::cout << "  " << (result.asynchronous_io ? "io_uring" : "blocking") << " I/O, read "
+		          << result.bytes_read * mib << " MiB, wrote " << result.bytes_written * mib << " MiB, "
+		          << (seconds > 0 ? result.bytes_read * mib / seconds : 0) << " MiB/s read" << std::endl;
+	}
 	return 0;
 }
 
-#endif
\ No newline at end of file
+static void print_usage(char const *program) {
+	std::cout << "Usage: " << program << " [--algorithms=NAME,...] [--datasets=NAME,...]\n"
+	          << "       [--jobs=N] [--cpus=LIST] [--reserve-cores=N] [--no-smt]\n"
+	          << "       [--max-size=N] [--budget=SECONDS] [--seed=N] [--types=NAME,...]\n"
+	          << "       [--results=FILE] [--compare=BASELINE[,CANDIDATE]] [--threshold=PERCENT]\n"
+	          << "       [--refine-crossovers]\n"
+	          << "       " << program << " --generate=FILE,MIB [--seed=N]\n"
+	          << "       " << program << " --external-sort=INPUT[,OUTPUT] [--memory=MIB] [--temp-dir=DIR] [--no-io-uring]\n"
+	          << "       " << program << " --mapped-sort=FILE [--memory=MIB] [--temp-dir=DIR]\n\n"
+	          << "  --jobs=N           run cells on N pinned workers, 0 for one per usable CPU\n"
+	          << "  --cpus=LIST        CPUs the benchmark may use, such as isolated cores 2-7\n"
+	          << "  --reserve-cores=N  leave the first N physical cores to the system\n"
+	          << "  --no-smt           use one hardware thread per core, leaving siblings idle\n"
+	          << "  --max-size=N       double the input size up to N, default " << MAX_INPUT_SIZE << "\n"
+	          << "  --budget=SECONDS   time allowed per cell, 0 for no limit, default " << CELL_TIME_BUDGET_SECONDS << "\n"
+	          << "                     cells predicted to take longer get fewer trials or are skipped\n"
+	          << "  --seed=N           generate the inputs of an earlier run again, random by default\n"
+	          << "  --types=NAME,...   value types to sort, default int\n"
+	          << "  --results=FILE     JSON lines results with the environment, default " << RESULTS_PATH << "\n"
+	          << "  --compare=BASE     compare the results of this run, or of CANDIDATE without running,\n"
+	          << "                     to those in BASE, and exit with status 2 on any significant\n"
+	          << "                     slowdown beyond --threshold, default " << REGRESSION_THRESHOLD_PERCENT << "%\n"
+	          << "                     BASE is read before the run, so it may be the --results file\n"
+	          << "  --refine-crossovers  measure sizes between the powers of two to find the exact\n"
+	          << "                     size where one algorithm overtakes another\n"
+	          << "  --generate=FILE,MIB  write MIB MiB of random 64-bit integers to FILE\n"
+	          << "  --external-sort=INPUT[,OUTPUT]\n"
+	          << "                     sort a file of 64-bit integers larger than memory, into\n"
+	          << "                     INPUT.sorted by default, and exit\n"
+	          << "  --mapped-sort=FILE sort a file of 64-bit integers in place through mmap, and exit\n"
+	          << "  --memory=MIB       memory budget of file sorts, default " << EXTERNAL_SORT_MEMORY_MIB << "\n"
+	          << "  --temp-dir=DIR     where file sorts spill their runs, default /tmp\n"
+	          << "  --no-io-uring      make --external-sort block on every read and write\n\nAlgorithms:";
+	for (auto const &algorithm : registered_algorithms<int>()) std::cout << " " << algorithm.name;
+	std::cout << "\nDatasets:";
+	for (auto const &dataset : registered_datasets<int>()) std::cout << " " << dataset.name;
+	std::cout << "\nTypes:";
+	for (auto const &type : VALUE_TYPES) std::cout << " " << type.name;
+	std::cout << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+	SweepOptions options(NUM_TRIALS);
+	BenchmarkConfig &config = options.config;
+	config.seed = (static_cast<std::uint64_t>(std::random_device()()) << 32) ^ static_cast<std::uint64_t>(std::time(nullptr));
+	config.warmup_runs = NUM_WARMUP_RUNS;
+	config.lock_memory = LOCK_MEMORY;
+	config.time_budget_ns = CELL_TIME_BUDGET_SECONDS * 1e9;
+
+	std::string type_names = value_type_name<int>();
+	std::string results_path = RESULTS_PATH, baseline_path, candidate_path;
+	std::string compare_arg, generate_arg, external_arg, mapped_path;
+	ExternalSortConfig external_config;
+	external_config.memory_budget = EXTERNAL_SORT_MEMORY_MIB << 20;
+	double threshold = REGRESSION_THRESHOLD_PERCENT / 100;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg.compare(0, 13, "--algorithms=") == 0) options.algorithm_names = arg.substr(13);
+		else if (arg.compare(0, 11, "--datasets=") == 0) options.dataset_names = arg.substr(11);
+		else if (arg.compare(0, 8, "--types=") == 0) type_names = arg.substr(8);
+		else if (arg.compare(0, 7, "--jobs=") == 0) config.jobs = std::strtoul(arg.c_str() + 7, nullptr, 10);
+		else if (arg.compare(0, 16, "--reserve-cores=") == 0) config.reserved_cores = std::strtoul(arg.c_str() + 16, nullptr, 10);
+		else if (arg == "--no-smt") config.idle_smt_siblings = true;
+		else if (arg == "--refine-crossovers") options.refine_crossovers = true;
+		else if (arg.compare(0, 11, "--generate=") == 0) generate_arg = arg.substr(11);
+		else if (arg.compare(0, 16, "--external-sort=") == 0) external_arg = arg.substr(16);
+		else if (arg.compare(0, 9, "--memory=") == 0) external_config.memory_budget = std::strtoull(arg.c_str() + 9, nullptr, 10) << 20;
+		else if (arg.compare(0, 14, "--mapped-sort=") == 0) mapped_path = arg.substr(14);
+		else if (arg.compare(0, 11, "--temp-dir=") == 0) external_config.temp_dir = arg.substr(11);
+		else if (arg == "--no-io-uring") external_config.asynchronous_io = false;
+		else if (arg.compare(0, 11, "--max-size=") == 0) options.max_input_size = std::strtoull(arg.c_str() + 11, nullptr, 10);
+		else if (arg.compare(0, 9, "--budget=") == 0) config.time_budget_ns = std::strtod(arg.c_str() + 9, nullptr) * 1e9;
+		else if (arg.compare(0, 7, "--seed=") == 0) config.seed = std::strtoull(arg.c_str() + 7, nullptr, 10);
+		else if (arg.compare(0, 10, "--results=") == 0) results_path = arg.substr(10);
+		else if (arg.compare(0, 10, "--compare=") == 0) compare_arg = arg.substr(10);
+		else if (arg.compare(0, 12, "--threshold=") == 0) threshold = std::strtod(arg.c_str() + 12, nullptr) / 100;
+		else if (arg.compare(0, 7, "--cpus=") == 0 && parse_cpu_list(arg.substr(7), config.cpus)) continue;
+		else {
+			print_usage(argv[0]);
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	// Read before the run, which may overwrite the baseline with its results
+	Results baseline, candidate;
+	split_pair(compare_arg, baseline_path, candidate_path);
+	if (!baseline_path.empty() && !load_results(baseline_path, baseline)) return 1;
+	if (!candidate_path.empty()) return load_results(candidate_path, candidate) ? compare(baseline, candidate, threshold) : 1;
+
+	if (!generate_arg.empty()) {
+		std::string path, mib;
+		split_pair(generate_arg, path, mib);
+		return generate_file(path, std::strtoull(mib.c_str(), nullptr, 10), config.seed);
+	}
+	if (!external_arg.empty()) {
+		std::string input_path, output_path;
+		split_pair(external_arg, input_path, output_path);
+		return sort_file(input_path, output_path.empty() ? input_path + ".sorted" : output_path, false, external_config);
+	}
+	if (!mapped_path.empty()) return sort_file(mapped_path, mapped_path, true, external_config);
+
+	// Names are checked against int, which every algorithm supports
+	std::vector<std::string> unknown;
+	const std::vector<ValueType> types = filter_by_name(std::vector<ValueType>(std::begin(VALUE_TYPES), std::end(VALUE_TYPES)), type_names, unknown);
+	filter_by_name(registered_algorithms<int>(), options.algorithm_names, unknown);
+	filter_by_name(registered_datasets<int>(), options.dataset_names, unknown);
+	if (!unknown.empty()) {
+		for (auto const &name : unknown) std::cerr << "Unknown algorithm, dataset or type: " << name << std::endl;
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	// randomized_quick_sort draws its pivots from std::rand
+	std::srand(static_cast<unsigned>(config.seed));
+	std::cout << "Seed = " << config.seed << " (rerun with --seed=" << config.seed << " for the same inputs)" << std::endl;
+	std::ofstream("benchmark_data/seed.txt", std::ofstream::out) << config.seed << "\n";
+
+	if (!perf_counters().available())
+		std::cout << "Hardware performance counters are unavailable (no PMU, or blocked by /proc/sys/kernel/perf_event_paranoid), recording runtimes only" << std::endl;
+
+	const std::vector<int> cpus = benchmark_cpus(config);
+	if (config.jobs == 0) config.jobs = std::max<std::size_t>(cpus.size(), 1);
+	if (config.jobs == 1 && !cpus.empty()) std::cout << "Running on CPU " << cpus[0] << ", multithreaded sorts on CPUs";
+	else std::cout << "Running on " << config.jobs << " workers pinned to CPUs";
+	for (int cpu : cpus) std::cout << " " << cpu;
+	if (cpus.empty()) std::cout << " (unpinned)";
+	std::cout << std::endl;
+
+	std::ofstream results(results_path, std::ofstream::out);
+	if (!results) {
+		std::cerr << "Cannot write " << results_path << std::endl;
+		return 1;
+	}
+	write_environment(results, config);
+	options.results = &results;
+
+	for (auto const &type : types) type.sweep(options);
+
+	results.close();
+	if (baseline_path.empty()) return 0;
+	return load_results(results_path, candidate) ? compare(baseline, candidate, threshold) : 1;
+}
+
+#endif
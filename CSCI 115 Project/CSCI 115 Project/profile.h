@@ -4,6 +4,17 @@
 #include <chrono>
 #include <algorithm>
 
+#if defined(__linux__)
+#   define PROFILE_HAVE_PERF_EVENTS 1
+#   include <cstring>
+#   include <linux/perf_event.h>
+#   include <sys/ioctl.h>
+#   include <sys/syscall.h>
+#   include <unistd.h>
+#else
+#   define PROFILE_HAVE_PERF_EVENTS 0
+#endif
+
 /**
  * Profiles the runtime a function.
  * 
@@ -20,4 +31,258 @@ std::chrono::microseconds profile(F&& func, Args&&... args)
     return std::chrono::duration_cast<std::chrono::microseconds>(stop - start);
 }
 
-#endif
\ No newline at end of file
+/**
+ * Hardware events counted while a function ran. valid is false when no
+ * counter could be opened, for example because perf_event_paranoid forbids
+ * it or the platform is not Linux. A single event the CPU or hypervisor
+ * does not support reads 0 while the others are still counted.
+ */
+struct HardwareCounters {
+    bool valid;
+    unsigned long long cycles;
+    unsigned long long instructions;
+    unsigned long long branch_misses;
+    unsigned long long l1d_misses;
+    unsigned long long llc_misses;
+    unsigned long long dtlb_misses;
+
+    HardwareCounters():
+        valid(false),
+        cycles(0),
+        instructions(0),
+        branch_misses(0),
+        l1d_misses(0),
+        llc_misses(0),
+        dtlb_misses(0) {}
+
+    HardwareCounters &operator+=(HardwareCounters const &other)
+    {
+        valid = valid || other.valid;
+        cycles += other.cycles;
+        instructions += other.instructions;
+        branch_misses += other.branch_misses;
+        l1d_misses += other.l1d_misses;
+        llc_misses += other.llc_misses;
+        dtlb_misses += other.dtlb_misses;
+        return *this;
+    }
+
+    HardwareCounters &operator/=(unsigned long long n)
+    {
+        cycles /= n;
+        instructions /= n;
+        branch_misses /= n;
+        l1d_misses /= n;
+        llc_misses /= n;
+        dtlb_misses /= n;
+        return *this;
+    }
+};
+
+/**
+ * Runtime and hardware counters of one call, as returned by
+ * profile_counters.
+ */
+struct ProfileResult {
+    std::chrono::nanoseconds time;
+    HardwareCounters counters;
+};
+
+/**
+ * The perf_event counters behind profile_counters. Every event is opened
+ * once, disabled, for the calling thread and the threads it creates later,
+ * and then enabled around each profiled call, which is credited with the
+ * difference between readings taken before and after it. Resetting the
+ * counters instead would not do: a reset leaves alone what threads that
+ * already exited added to them, so every call would also be charged with
+ * the threads of the calls before it. A thread's counts only reach the
+ * counters once the kernel is done with its exit, which can be just after
+ * it was joined, so part of the counts of the threads a call starts may be
+ * charged to the next call instead. Events are opened one by one rather
+ * than as a group so that an unsupported event does not disable the
+ * others, and readings are scaled up when the kernel had to multiplex more
+ * events than the CPU has counters.
+ */
+class PerfCounters {
+public:
+    enum Event { CYCLES, INSTRUCTIONS, BRANCH_MISSES, L1D_MISSES, LLC_MISSES, DTLB_MISSES, NUM_EVENTS };
+
+    PerfCounters()
+    {
+        for (int i = 0; i < NUM_EVENTS; ++i) fds[i] = open_event(static_cast<Event>(i));
+    }
+
+    /**
+     * Opens the single event of perf type and config in place of the
+     * cycles, such as the task-clock software event on machines without
+     * hardware counters.
+     */
+    PerfCounters(unsigned type, unsigned long long config)
+    {
+        fds[CYCLES] = open_event(type, config);
+        for (int i = CYCLES + 1; i < NUM_EVENTS; ++i) fds[i] = -1;
+    }
+
+    ~PerfCounters()
+    {
+#if PROFILE_HAVE_PERF_EVENTS
+        for (int i = 0; i < NUM_EVENTS; ++i)
+            if (fds[i] >= 0) close(fds[i]);
+#endif
+    }
+
+    PerfCounters(PerfCounters const &) = delete;
+    PerfCounters &operator=(PerfCounters const &) = delete;
+
+    /**
+     * Returns whether at least one event could be opened.
+     */
+    bool available() const
+    {
+        return std::any_of(fds, fds + NUM_EVENTS, [](int fd) { return fd >= 0; });
+    }
+
+    void start()
+    {
+#if PROFILE_HAVE_PERF_EVENTS
+        for (int i = 0; i < NUM_EVENTS; ++i)
+        {
+            if (fds[i] < 0) continue;
+            if (!read_event(fds[i], before[i])) before[i][0] = before[i][1] = before[i][2] = 0;
+            ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    HardwareCounters stop()
+    {
+        unsigned long long values[NUM_EVENTS] = {};
+#if PROFILE_HAVE_PERF_EVENTS
+        for (int i = 0; i < NUM_EVENTS; ++i)
+            if (fds[i] >= 0) ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        for (int i = 0; i < NUM_EVENTS; ++i)
+        {
+            unsigned long long after[3];
+            if (fds[i] < 0 || !read_event(fds[i], after)) continue;
+            const unsigned long long value = after[0] - before[i][0];
+            const unsigned long long enabled = after[1] - before[i][1];
+            const unsigned long long running = after[2] - before[i][2];
+            if (running == 0) continue;
+            values[i] = running < enabled
+                ? static_cast<unsigned long long>(static_cast<double>(value) * enabled / running)
+                : value;
+        }
+#endif
+        HardwareCounters result;
+        result.valid = available();
+        result.cycles = values[CYCLES];
+        result.instructions = values[INSTRUCTIONS];
+        result.branch_misses = values[BRANCH_MISSES];
+        result.l1d_misses = values[L1D_MISSES];
+        result.llc_misses = values[LLC_MISSES];
+        result.dtlb_misses = values[DTLB_MISSES];
+        return result;
+    }
+
+private:
+    static int open_event(Event event)
+    {
+#if PROFILE_HAVE_PERF_EVENTS
+        const unsigned long long read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        switch (event)
+        {
+            case CYCLES:        return open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+            case INSTRUCTIONS:  return open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+            case BRANCH_MISSES: return open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+            case L1D_MISSES:    return open_event(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | read_miss);
+            case LLC_MISSES:    return open_event(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | read_miss);
+            default:            return open_event(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | read_miss);
+        }
+#else
+        (void)event;
+        return -1;
+#endif
+    }
+
+    static int open_event(unsigned type, unsigned long long config)
+    {
+#if PROFILE_HAVE_PERF_EVENTS
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // Fails with EACCES when perf_event_paranoid forbids counting, or
+        // ENOENT/EOPNOTSUPP when the event does not exist on this machine
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)type;
+        (void)config;
+        return -1;
+#endif
+    }
+
+    /**
+     * Reads the value, time enabled and time running of the event of fd.
+     */
+    static bool read_event(int fd, unsigned long long (&data)[3])
+    {
+#if PROFILE_HAVE_PERF_EVENTS
+        return read(fd, data, sizeof(data)) == sizeof(data);
+#else
+        (void)fd;
+        (void)data;
+        return false;
+#endif
+    }
+
+    int fds[NUM_EVENTS];
+    unsigned long long before[NUM_EVENTS][3];
+};
+
+/**
+ * The counters profile_counters uses on the calling thread, opened on the
+ * thread's first use. Every thread has its own, since enabling and reading
+ * counters shared by concurrent threads would mix up their calls.
+ */
+inline PerfCounters &perf_counters()
+{
+    static thread_local PerfCounters perf;
+    return perf;
+}
+
+/**
+ * Profiles the runtime of a function together with hardware performance
+ * counters: cycles, instructions, branch misses and L1D, LLC and dTLB read
+ * misses, including those of threads the function starts. When the
+ * counters are unavailable the result holds the runtime only and
+ * counters.valid is false.
+ *
+ * @param func function of any return type accepting args as arguments.
+ * @param args variable number of arguments to be passed into func.
+ * @returns the runtime of func in nanoseconds, measured with the monotonic
+ *          steady_clock, and the events it caused.
+ */
+template <typename F, typename ... Args>
+ProfileResult profile_counters(F&& func, Args&&... args)
+{
+    PerfCounters &perf = perf_counters();
+
+    ProfileResult result;
+    perf.start();
+    const auto start = std::chrono::steady_clock::now();
+    std::forward<F>(func)(std::forward<Args>(args)...);
+    const auto stop = std::chrono::steady_clock::now();
+    result.counters = perf.stop();
+    result.time = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start);
+    return result;
+}
+
+#endif
@@ -0,0 +1,175 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+/**
+ * Returns the next output of the splitmix64 generator with state x, and
+ * advances x. Its outputs are well mixed even for consecutive or zero
+ * states, which makes it the recommended way to seed xoshiro.
+ */
+inline std::uint64_t splitmix64(std::uint64_t &x)
+{
+    std::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * The xoshiro256** pseudo-random generator of Blackman and Vigna: fast,
+ * 256 bits of state and good statistical quality. Unlike std::rand it has
+ * no hidden global state, so every thread can own one, and the same seed
+ * and stream always produce the same sequence on every platform.
+ *
+ * Meets the requirements of a UniformRandomBitGenerator.
+ */
+class Xoshiro256 {
+public:
+    typedef std::uint64_t result_type;
+
+    /**
+     * Seeds the generator for stream number stream of seed. Different
+     * streams of a seed are independent, so parallel code gives every chunk
+     * of work its own stream and gets the same numbers whatever thread runs
+     * which chunk.
+     */
+    explicit Xoshiro256(std::uint64_t seed, std::uint64_t stream = 0)
+    {
+        std::uint64_t x = seed;
+        x = splitmix64(x) ^ stream;
+        for (int i = 0; i < 4; ++i) s[i] = splitmix64(x);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        const std::uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const std::uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::uint64_t s[4];
+};
+
+/**
+ * Returns a uniformly distributed integer in [0, n) by Lemire's
+ * multiply-shift method, which avoids the division of rand() % n and its
+ * bias towards small values. The bias left is below n / 2^64.
+ */
+template <typename Rng>
+std::uint64_t uniform_below(Rng &rng, std::uint64_t n)
+{
+#if defined(__SIZEOF_INT128__)
+    return static_cast<std::uint64_t>((static_cast<unsigned __int128>(rng()) * n) >> 64);
+#else
+    return rng() % n;
+#endif
+}
+
+/**
+ * Returns a uniformly distributed double in [0, 1) from the top 53 bits.
+ */
+template <typename Rng>
+double uniform_real(Rng &rng)
+{
+    return (rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Returns a normally distributed double with the given mean and standard
+ * deviation by the Box-Muller transform. Unlike std::normal_distribution
+ * the result is the same with every standard library.
+ */
+template <typename Rng>
+double normal(Rng &rng, double mean, double stddev)
+{
+    const double u = 1.0 - uniform_real(rng);
+    const double v = uniform_real(rng);
+    return mean + stddev * std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * v);
+}
+
+/**
+ * Zipf distribution over the ranks 1..n, rank k having a probability
+ * proportional to 1 / k^exponent. Samples in constant expected time by the
+ * rejection-inversion method of Hörmann and Derflinger, so n may be as
+ * large as the input without tabulating anything.
+ */
+class ZipfDistribution {
+public:
+    ZipfDistribution(std::uint64_t n, double exponent):
+        n(n),
+        exponent(exponent),
+        h_integral_x1(h_integral(1.5) - 1),
+        h_integral_n(h_integral(n + 0.5)),
+        threshold(2 - h_integral_inverse(h_integral(2.5) - h(2))) {}
+
+    template <typename Rng>
+    std::uint64_t operator()(Rng &rng) const
+    {
+        for (;;) {
+            const double u = h_integral_n + uniform_real(rng) * (h_integral_x1 - h_integral_n);
+            const double x = h_integral_inverse(u);
+            double k = std::floor(x + 0.5);
+            if (k < 1) k = 1;
+            else if (k > n) k = static_cast<double>(n);
+            if (k - x <= threshold || u >= h_integral(k + 0.5) - h(k))
+                return static_cast<std::uint64_t>(k);
+        }
+    }
+
+private:
+    double h(double x) const
+    {
+        return std::exp(-exponent * std::log(x));
+    }
+
+    // Integral of h, and its inverse, written to stay accurate as exponent
+    // approaches 1 where the closed forms divide by zero
+    double h_integral(double x) const
+    {
+        const double log_x = std::log(x);
+        return expm1_over_x((1 - exponent) * log_x) * log_x;
+    }
+
+    double h_integral_inverse(double x) const
+    {
+        double t = x * (1 - exponent);
+        if (t < -1) t = -1;
+        return std::exp(log1p_over_x(t) * x);
+    }
+
+    static double expm1_over_x(double x)
+    {
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x / 3 * (1 + 0.25 * x));
+    }
+
+    static double log1p_over_x(double x)
+    {
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+
+    std::uint64_t n;
+    double exponent;
+    double h_integral_x1;
+    double h_integral_n;
+    double threshold;
+};
+
+#endif
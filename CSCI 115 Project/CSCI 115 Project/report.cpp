@@ -0,0 +1,339 @@
+#include "report.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#	include <sys/utsname.h>
+#	include <unistd.h>
+#	define REPORT_HAVE_UNAME 1
+#else
+#	define REPORT_HAVE_UNAME 0
+#endif
+
+// The Makefile passes the flags and commit the benchmark was built from
+#ifndef BENCHMARK_CFLAGS
+#	define BENCHMARK_CFLAGS "unknown"
+#endif
+#ifndef BENCHMARK_COMMIT
+#	define BENCHMARK_COMMIT "unknown"
+#endif
+
+// -----------------------------------------------------------
+// Private helper methods
+// -----------------------------------------------------------
+
+static std::string compiler_version() {
+#if defined(__clang__)
+	return __VERSION__;
+#elif defined(__GNUC__)
+	return "GCC " __VERSION__;
+#elif defined(_MSC_FULL_VER)
+	return "MSVC " + std::to_string(_MSC_FULL_VER);
+#else
+	return "unknown";
+#endif
+}
+
+/**
+ * Returns the CPU model as the kernel reports it, or "unknown".
+ */
+static std::string cpu_model() {
+	std::ifstream cpuinfo("/proc/cpuinfo");
+	std::string line;
+	while (std::getline(cpuinfo, line)) {
+		if (line.compare(0, 10, "model name") != 0) continue;
+		const std::string::size_type colon = line.find(':');
+		if (colon != std::string::npos) return line.substr(line.find_first_not_of(" \t", colon + 1));
+	}
+	return "unknown";
+}
+
+static std::string utc_timestamp() {
+	const std::time_t now = std::time(nullptr);
+	char text[32];
+	std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+	return text;
+}
+
+static void write_key(std::ostream &out, char const *key, bool first) {
+	if (!first) out << ",";
+	write_json_string(out, key);
+	out << ":";
+}
+
+static void write_field(std::ostream &out, char const *key, std::string const &value, bool first = false) {
+	write_key(out, key, first);
+	write_json_string(out, value);
+}
+
+template <typename Number>
+static void write_field(std::ostream &out, char const *key, Number value, bool first = false) {
+	write_key(out, key, first);
+	out << value;
+}
+
+static double number(std::map<std::string, std::string> const &fields, char const *key) {
+	auto it = fields.find(key);
+	return it == fields.end() ? 0 : std::strtod(it->second.c_str(), nullptr);
+}
+
+static std::string text(std::map<std::string, std::string> const &fields, char const *key) {
+	auto it = fields.find(key);
+	return it == fields.end() ? std::string() : it->second;
+}
+
+/**
+ * Formats a time in nanoseconds with a unit that keeps it short.
+ */
+static std::string format_time(double ns) {
+	std::ostringstream out;
+	out << std::setprecision(3);
+	if (ns >= 1e9) out << ns / 1e9 << " s";
+	else if (ns >= 1e6) out << ns / 1e6 << " ms";
+	else if (ns >= 1e3) out << ns / 1e3 << " us";
+	else out << ns << " ns";
+	return out.str();
+}
+
+// -----------------------------------------------------------
+// Public API
+// -----------------------------------------------------------
+
+char const *cell_status_name(CellResult::Status status) {
+	static char const *const names[] = { "measured", "reduced", "skipped" };
+	return names[status];
+}
+
+void write_json_string(std::ostream &out, std::string const &s) {
+	out << '"';
+	for (char c : s) {
+		switch (c) {
+			case '"':  out << "\\\""; break;
+			case '\\': out << "\\\\"; break;
+			case '\n': out << "\\n"; break;
+			case '\t': out << "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					char escaped[8];
+					std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+					out << escaped;
+				} else {
+					out << c;
+				}
+		}
+	}
+	out << '"';
+}
+
+void write_environment(std::ostream &out, BenchmarkConfig const &config) {
+	std::string os = "unknown", host = "unknown";
+#if REPORT_HAVE_UNAME
+	utsname name;
+	if (uname(&name) == 0) {
+		os = std::string(name.sysname) + " " + name.release + " " + name.machine;
+		host = name.nodename;
+	}
+#endif
+
+	out << "{";
+	write_field(out, "type", std::string("environment"), true);
+	write_field(out, "timestamp", utc_timestamp());
+	write_field(out, "commit", std::string(BENCHMARK_COMMIT));
+	write_field(out, "compiler", compiler_version());
+	write_field(out, "flags", std::string(BENCHMARK_CFLAGS));
+	write_field(out, "cpu", cpu_model());
+	write_field(out, "logical_cpus", std::thread::hardware_concurrency());
+	write_field(out, "os", os);
+	write_field(out, "host", host);
+	write_field(out, "perf_counters", perf_counters().available() ? "true" : "false");
+	// As a string, since JSON readers may hold numbers in doubles
+	write_field(out, "seed", std::to_string(config.seed));
+	write_field(out, "warmup_runs", config.warmup_runs);
+	write_field(out, "min_trials", config.min_trials);
+	write_field(out, "max_trials", config.max_trials);
+	write_field(out, "target_ci", config.target_ci);
+	write_field(out, "reject_outliers", config.reject_outliers ? "true" : "false");
+	write_field(out, "jobs", config.jobs);
+	write_field(out, "time_budget_ns", config.time_budget_ns);
+	out << "}\n";
+	out.flush();
+}
+
+void write_json_cell(std::ostream &out, char const *value_type, char const *algorithm, char const *dataset,
+                     std::size_t input_size, CellResult const &cell) {
+	const std::streamsize precision = out.precision(12);
+	TimingStats const &time = cell.time;
+
+	out << "{";
+	write_field(out, "type", std::string("cell"), true);
+	write_field(out, "value_type", std::string(value_type));
+	write_field(out, "algorithm", std::string(algorithm));
+	write_field(out, "dataset", std::string(dataset));
+	write_field(out, "n", input_size);
+	write_field(out, "status", std::string(cell_status_name(cell.status)));
+	write_field(out, "predicted_ns", cell.predicted_ns);
+	if (cell.status != CellResult::SKIPPED) {
+		write_field(out, "trials", time.trials);
+		write_field(out, "outliers", time.outliers);
+		write_field(out, "min_ns", time.min);
+		write_field(out, "median_ns", time.median);
+		write_field(out, "p90_ns", time.p90);
+		write_field(out, "p99_ns", time.p99);
+		write_field(out, "mean_ns", time.mean);
+		write_field(out, "stddev_ns", time.stddev);
+		write_field(out, "comparisons", cell.ops.comparisons);
+		write_field(out, "moves", cell.ops.moves);
+		if (cell.memory_measured) write_field(out, "peak_memory_bytes", cell.peak_memory);
+	}
+	if (cell.hw.valid) {
+		write_field(out, "cycles", cell.hw.cycles);
+		write_field(out, "instructions", cell.hw.instructions);
+		write_field(out, "branch_misses", cell.hw.branch_misses);
+		write_field(out, "l1d_misses", cell.hw.l1d_misses);
+		write_field(out, "llc_misses", cell.hw.llc_misses);
+		write_field(out, "dtlb_misses", cell.hw.dtlb_misses);
+	}
+	out << "}\n";
+	out.precision(precision);
+}
+
+bool parse_json_object(std::string const &line, std::map<std::string, std::string> &fields) {
+	std::size_t i = 0;
+	auto skip_space = [&]() { while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) ++i; };
+	auto parse_string = [&](std::string &s) {
+		if (i >= line.size() || line[i] != '"') return false;
+		for (++i; i < line.size() && line[i] != '"'; ++i) {
+			if (line[i] != '\\') { s += line[i]; continue; }
+			if (++i >= line.size()) return false;
+			switch (line[i]) {
+				case 'n': s += '\n'; break;
+				case 't': s += '\t'; break;
+				case 'u':
+					if (i + 4 >= line.size()) return false;
+					s += static_cast<char>(std::strtol(line.substr(i + 1, 4).c_str(), nullptr, 16));
+					i += 4;
+					break;
+				default: s += line[i];
+			}
+		}
+		return i++ < line.size();
+	};
+
+	skip_space();
+	if (i >= line.size() || line[i++] != '{') return false;
+	skip_space();
+	if (i < line.size() && line[i] == '}') return true;
+
+	for (;;) {
+		std::string key, value;
+		skip_space();
+		if (!parse_string(key)) return false;
+		skip_space();
+		if (i >= line.size() || line[i++] != ':') return false;
+		skip_space();
+		if (i < line.size() && line[i] == '"') {
+			if (!parse_string(value)) return false;
+		} else {
+			while (i < line.size() && line[i] != ',' && line[i] != '}' && !std::isspace(static_cast<unsigned char>(line[i])))
+				value += line[i++];
+			if (value.empty()) return false;
+		}
+		fields[key] = value;
+
+		skip_space();
+		if (i >= line.size()) return false;
+		if (line[i] == '}') return true;
+		if (line[i++] != ',') return false;
+	}
+}
+
+bool read_results(std::string const &path, std::vector<CellSummary> &cells,
+                  std::map<std::string, std::string> &environment, std::string &error) {
+	std::ifstream in(path);
+	if (!in) {
+		error = "cannot open " + path;
+		return false;
+	}
+
+	std::string line;
+	for (std::size_t line_number = 1; std::getline(in, line); ++line_number) {
+		if (line.empty()) continue;
+		std::map<std::string, std::string> fields;
+		if (!parse_json_object(line, fields)) {
+			error = path + ":" + std::to_string(line_number) + ": not a JSON object";
+			return false;
+		}
+
+		const std::string type = text(fields, "type");
+		if (type == "environment") {
+			environment = fields;
+		} else if (type == "cell") {
+			CellSummary cell;
+			cell.value_type = text(fields, "value_type");
+			cell.algorithm = text(fields, "algorithm");
+			cell.dataset = text(fields, "dataset");
+			cell.input_size = static_cast<std::size_t>(number(fields, "n"));
+			cell.measured = text(fields, "status") != "skipped";
+			cell.trials = static_cast<std::size_t>(number(fields, "trials"));
+			cell.median = number(fields, "median_ns");
+			cell.mean = number(fields, "mean_ns");
+			cell.stddev = number(fields, "stddev_ns");
+			cells.push_back(cell);
+		}
+	}
+	return true;
+}
+
+std::size_t compare_results(std::vector<CellSummary> const &baseline, std::vector<CellSummary> const &candidate,
+                            double threshold, std::ostream &out) {
+	typedef std::pair<std::pair<std::string, std::string>, std::pair<std::string, std::size_t>> Key;
+	auto key = [](CellSummary const &cell) {
+		return Key(std::make_pair(cell.value_type, cell.algorithm), std::make_pair(cell.dataset, cell.input_size));
+	};
+
+	std::map<Key, CellSummary const *> before;
+	for (auto const &cell : baseline)
+		if (cell.measured && cell.median > 0) before[key(cell)] = &cell;
+
+	// Relative change of the median, and the cell
+	std::vector<std::pair<double, CellSummary const *>> changes;
+	std::size_t compared = 0, slower = 0, faster = 0;
+	for (auto const &cell : candidate) {
+		auto match = before.find(key(cell));
+		if (!cell.measured || match == before.end()) continue;
+		CellSummary const &old = *match->second;
+		++compared;
+
+		const double change = cell.median / old.median - 1;
+		if (std::abs(change) <= threshold) continue;
+		if (!significantly_different(old.mean, old.stddev, old.trials, cell.mean, cell.stddev, cell.trials)) continue;
+
+		changes.push_back(std::make_pair(change, &cell));
+		if (change > 0) ++slower;
+		else ++faster;
+	}
+
+	std::sort(changes.begin(), changes.end(), [](std::pair<double, CellSummary const *> const &x, std::pair<double, CellSummary const *> const &y) {
+		return x.first > y.first;
+	});
+
+	out << "Compared " << compared << " cells, threshold " << threshold * 100 << "%: "
+	    << slower << " slower, " << faster << " faster" << std::endl;
+	for (auto const &change : changes) {
+		CellSummary const &cell = *change.second;
+		CellSummary const &old = *before[key(cell)];
+		out << (change.first > 0 ? "  SLOWER " : "  faster ")
+		    << std::showpos << std::fixed << std::setprecision(1) << change.first * 100 << "%"
+		    << std::noshowpos << std::defaultfloat << "  "
+		    << cell.value_type << " " << cell.algorithm << " " << cell.dataset << " N=" << cell.input_size
+		    << "  (median " << format_time(old.median) << " -> " << format_time(cell.median) << ")" << std::endl;
+	}
+	return slower;
+}
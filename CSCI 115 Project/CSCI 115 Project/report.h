@@ -0,0 +1,94 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "benchmark.h"
+
+// -----------------------------------------------------------
+// Machine-readable results
+//
+// A results file holds JSON lines: first one "environment" object
+// describing the machine, build and settings of the run, then one "cell"
+// object per algorithm, dataset, value type and size. Every object is flat,
+// with string, number and boolean values only.
+// -----------------------------------------------------------
+
+/**
+ * Returns "measured", "reduced" or "skipped".
+ */
+char const *cell_status_name(CellResult::Status status);
+
+/**
+ * Writes s as a quoted JSON string.
+ */
+void write_json_string(std::ostream &out, std::string const &s);
+
+/**
+ * Writes the environment line: compiler, flags, commit, CPU, seed and the
+ * measurement settings of config.
+ */
+void write_environment(std::ostream &out, BenchmarkConfig const &config);
+
+/**
+ * Writes one cell line.
+ */
+void write_json_cell(std::ostream &out, char const *value_type, char const *algorithm, char const *dataset,
+                     std::size_t input_size, CellResult const &cell);
+
+/**
+ * Writes a cell line for every algorithm and dataset of a size of table.
+ */
+template <typename T>
+void write_json_cells(std::ostream &out, ResultTable<T> const &table, std::size_t size_index)
+{
+	for (std::size_t a = 0; a < table.algorithms().size(); ++a)
+		for (std::size_t d = 0; d < table.datasets().size(); ++d)
+			write_json_cell(out, value_type_name<T>(), table.algorithms()[a].name, table.datasets()[d].name,
+			                table.sizes()[size_index], table.at(a, d, size_index));
+	out.flush();
+}
+
+/**
+ * Parses one flat JSON object into its fields, string values unescaped and
+ * other values as written. Returns false when line is not such an object.
+ */
+bool parse_json_object(std::string const &line, std::map<std::string, std::string> &fields);
+
+/**
+ * The part of a cell line that runs are compared by.
+ */
+struct CellSummary {
+	std::string value_type;
+	std::string algorithm;
+	std::string dataset;
+	std::size_t input_size;
+	bool measured;
+	std::size_t trials;
+	double median;
+	double mean;
+	double stddev;
+};
+
+/**
+ * Reads the cell lines of the results file at path into cells, and its
+ * environment line into environment. Returns false with a message in error
+ * when the file cannot be read.
+ */
+bool read_results(std::string const &path, std::vector<CellSummary> &cells,
+                  std::map<std::string, std::string> &environment, std::string &error);
+
+/**
+ * Compares every cell measured in both baseline and candidate and prints
+ * the cells whose median changed significantly, by Welch's t-test on the
+ * trial means, and by more than threshold, a fraction such as 0.05.
+ *
+ * @returns the number of significant slowdowns beyond threshold.
+ */
+std::size_t compare_results(std::vector<CellSummary> const &baseline, std::vector<CellSummary> const &candidate,
+                            double threshold, std::ostream &out);
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef SMALL_SORT_H
+#define SMALL_SORT_H
+
+#include <climits>
+#include <cstddef>
+
+#include "counters.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   define SMALL_SORT_HAVE_AVX2 1
+#   include <immintrin.h>
+#else
+#   define SMALL_SORT_HAVE_AVX2 0
+#endif
+
+/**
+ * Largest range the vectorized kernel sorts: eight AVX2 registers of eight
+ * 32-bit lanes each.
+ */
+constexpr std::ptrdiff_t SMALL_SORT_MAX = 64;
+
+/**
+ * Returns whether the CPU and operating system support AVX2. The cpuid query
+ * runs once and is cached.
+ */
+inline bool cpu_has_avx2()
+{
+#if SMALL_SORT_HAVE_AVX2
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+#else
+    return false;
+#endif
+}
+
+#if SMALL_SORT_HAVE_AVX2
+
+/**
+ * One compare-exchange stage inside a register: every lane is compared with
+ * the lane selected by Partner and keeps the minimum, or the maximum where
+ * the lane's bit in MaxMask is set.
+ */
+template <int Partner, int MaxMask>
+__attribute__((target("avx2")))
+inline __m256i avx2_lane_stage(__m256i v)
+{
+    __m256i p;
+    if (Partner == 4) p = _mm256_permute2x128_si256(v, v, 1);
+    else if (Partner == 2) p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+    else p = _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), MaxMask);
+}
+
+/**
+ * Sorts the eight lanes of a bitonic register in ascending order.
+ */
+__attribute__((target("avx2")))
+inline __m256i avx2_bitonic_clean(__m256i v)
+{
+    v = avx2_lane_stage<4, 0xF0>(v);
+    v = avx2_lane_stage<2, 0xCC>(v);
+    return avx2_lane_stage<1, 0xAA>(v);
+}
+
+/**
+ * Sorts the eight lanes of a register with a bitonic sorting network.
+ */
+__attribute__((target("avx2")))
+inline __m256i avx2_sort_lanes(__m256i v)
+{
+    v = avx2_lane_stage<1, 0x66>(v);
+    v = avx2_lane_stage<2, 0x3C>(v);
+    v = avx2_lane_stage<1, 0x5A>(v);
+    return avx2_bitonic_clean(v);
+}
+
+__attribute__((target("avx2")))
+inline __m256i avx2_reverse_lanes(__m256i v)
+{
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+/**
+ * Sorts the 8 * R values held in r[0..R) so that lanes ascend within each
+ * register and across registers. Every register is sorted on its own, then
+ * sorted runs of 1, 2, 4, ... registers are merged pairwise with bitonic
+ * merges: the second run is reversed, corresponding registers are
+ * compare-exchanged at halving distances and every register is finished in
+ * place. comp counts the scalar comparisons the network performs.
+ */
+template <int R, typename Counter>
+__attribute__((target("avx2")))
+inline void avx2_sort_registers(__m256i *r, Counter &comp)
+{
+    for (int i = 0; i < R; ++i) r[i] = avx2_sort_lanes(r[i]);
+    count_comparisons(comp, R * 6 * 4);
+
+    for (int run = 1; run < R; run *= 2)
+    {
+        for (int base = 0; base < R; base += 2 * run)
+        {
+            __m256i *b = r + base + run;
+            for (int i = 0; i < run / 2; ++i)
+            {
+                __m256i tmp = b[i];
+                b[i] = b[run - 1 - i];
+                b[run - 1 - i] = tmp;
+            }
+            for (int i = 0; i < run; ++i) b[i] = avx2_reverse_lanes(b[i]);
+
+            for (int d = run; d > 0; d /= 2)
+            {
+                for (int i = base; i < base + 2 * run; ++i)
+                {
+                    if ((i - base) & d) continue;
+                    __m256i lo = _mm256_min_epi32(r[i], r[i + d]);
+                    r[i + d] = _mm256_max_epi32(r[i], r[i + d]);
+                    r[i] = lo;
+                    count_comparisons(comp, 8);
+                }
+            }
+            for (int i = base; i < base + 2 * run; ++i) r[i] = avx2_bitonic_clean(r[i]);
+            count_comparisons(comp, 2 * run * 3 * 4);
+        }
+    }
+}
+
+/**
+ * Sorts the n <= SMALL_SORT_MAX ints starting at data with AVX2 sorting
+ * networks. The values are padded with INT_MAX up to the next power-of-two
+ * number of registers, so ranges of up to 8, 16, 32 and 64 elements cost one,
+ * two, four and eight registers of work.
+ */
+template <typename Counter>
+__attribute__((target("avx2")))
+inline void avx2_small_sort(int *data, std::ptrdiff_t n, Counter &comp)
+{
+    alignas(32) int buffer[SMALL_SORT_MAX];
+    const int registers = n <= 8 ? 1 : n <= 16 ? 2 : n <= 32 ? 4 : 8;
+
+    for (std::ptrdiff_t i = 0; i < n; ++i) buffer[i] = data[i];
+    for (std::ptrdiff_t i = n; i < 8 * registers; ++i) buffer[i] = INT_MAX;
+
+    __m256i r[8];
+    for (int i = 0; i < registers; ++i)
+        r[i] = _mm256_load_si256(reinterpret_cast<__m256i const *>(buffer + 8 * i));
+
+    switch (registers)
+    {
+        case 1: avx2_sort_registers<1, Counter>(r, comp); break;
+        case 2: avx2_sort_registers<2, Counter>(r, comp); break;
+        case 4: avx2_sort_registers<4, Counter>(r, comp); break;
+        default: avx2_sort_registers<8, Counter>(r, comp); break;
+    }
+
+    for (int i = 0; i < registers; ++i)
+        _mm256_store_si256(reinterpret_cast<__m256i *>(buffer + 8 * i), r[i]);
+    for (std::ptrdiff_t i = 0; i < n; ++i) data[i] = buffer[i];
+    count_moves(comp, 2 * n);
+}
+
+#endif
+
+#endif
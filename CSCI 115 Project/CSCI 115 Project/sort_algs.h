@@ -3,6 +3,18 @@
 
 #include <vector>
 #include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "counters.h"
+#include "random.h"
+#include "small_sort.h"
+#include "thread_pool.h"
 
 template <typename RandomAccessIterator>
 void exch(RandomAccessIterator i, RandomAccessIterator j) {
@@ -11,6 +23,12 @@ void exch(RandomAccessIterator i, RandomAccessIterator j) {
     *j = tmp;
 }
 
+template <typename RandomAccessIterator, typename Counter>
+void exch(RandomAccessIterator i, RandomAccessIterator j, Counter &comp) {
+    exch(i, j);
+    count_moves(comp, 3);
+}
+
 template <typename T>
 void swap(std::vector<T> vec[], int i, int j)
 {
@@ -30,21 +48,62 @@ void swap(std::vector<T> vec[], int i, int j)
  * @param end   iterator referring to the past-the-end element in the range to
  *              be sorted, such as the iterator returned by std::vector::end.
  */ 
-template <typename RandomAccessIterator>
-void insertion_sort(RandomAccessIterator begin, RandomAccessIterator end, unsigned long &comp) {
+template <typename RandomAccessIterator, typename Counter>
+void insertion_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp) {
     if (begin == end) return;
 
     for (auto i = begin + 1; i < end; ++i) {
         auto key = *i;
         auto j = i - 1;
-        comp++;
+        count_comparisons(comp);
         while (j >= begin && key < *j) {
             *(j + 1) = *j;
             --j;
-            comp++;
+            count_comparisons(comp);
+            count_moves(comp);
         }
         *(j + 1) = key;
+        count_moves(comp, 2);
+    }
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order. 
+ * The order of equal elements is not guaranteed to be preserved.
+ * 
+ * Base case for hybrid sorts. Ranges of at most SMALL_SORT_MAX ints are
+ * sorted with AVX2 sorting networks when the CPU supports them; every other
+ * range is handed to insertion_sort.
+ * 
+ * @param begin iterator pointing to the first element in the range to be
+ *              sorted, such as the iterator returned by std::vector::begin.
+ * @param end   iterator referring to the past-the-end element in the range to
+ *              be sorted, such as the iterator returned by std::vector::end.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void small_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    insertion_sort(begin, end, comp);
+}
+
+template <typename Counter>
+void small_sort(int *begin, int *end, Counter &comp)
+{
+#if SMALL_SORT_HAVE_AVX2
+    if (end - begin > 1 && end - begin <= SMALL_SORT_MAX && cpu_has_avx2())
+    {
+        avx2_small_sort(begin, end - begin, comp);
+        return;
     }
+#endif
+    insertion_sort(begin, end, comp);
+}
+
+template <typename Counter>
+void small_sort(std::vector<int>::iterator begin, std::vector<int>::iterator end, Counter &comp)
+{
+    if (begin == end) return;
+    small_sort(&*begin, &*begin + (end - begin), comp);
 }
 
 /**
@@ -58,8 +117,8 @@ void insertion_sort(RandomAccessIterator begin, RandomAccessIterator end, unsign
  * @param end   iterator referring to the past-the-end element in the range to
  *              be sorted, such as the iterator returned by std::vector::end.
  */ 
-template <typename RandomAccessIterator>
-void selection_sort(RandomAccessIterator begin, RandomAccessIterator end, unsigned long &comp) {
+template <typename RandomAccessIterator, typename Counter>
+void selection_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp) {
     if (begin == end) return;
 
     for (auto i = begin; i < end - 1; ++i) {
@@ -68,9 +127,9 @@ void selection_sort(RandomAccessIterator begin, RandomAccessIterator end, unsign
             if (*j < *min) {
                 min = j;
             }
-            comp++;
+            count_comparisons(comp);
         }
-        exch(i, min);
+        exch(i, min, comp);
     }
 }
 
@@ -85,8 +144,8 @@ void selection_sort(RandomAccessIterator begin, RandomAccessIterator end, unsign
  * @param end   iterator referring to the past-the-end element in the range to
  *              be sorted, such as the iterator returned by std::vector::end.
  */ 
-template <typename RandomAccessIterator>
-void bubble_sort(RandomAccessIterator begin, RandomAccessIterator end, unsigned long &comp) {
+template <typename RandomAccessIterator, typename Counter>
+void bubble_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp) {
     if (begin == end) return;
 
     bool didSwap = false;
@@ -94,90 +153,237 @@ void bubble_sort(RandomAccessIterator begin, RandomAccessIterator end, unsigned
     for (auto i = end - 1; i > begin; --i) {
         for (auto j = begin; j < i; ++j) {
             if (*(j + 1) < *j) {
-                exch(j, j + 1);
+                exch(j, j + 1, comp);
                 didSwap = true;
             }
-            comp++;
+            count_comparisons(comp);
         }
         if (!didSwap) return;
     }
 }
 
 /**
- * Merges the two contiguous, pre-sorted ranges defined by [leftBegin, mid)
- * and [mid, rightEnd) guaranteeing that [leftBegin, rightEnd) is sorted in
- * ascending order
+ * Merges the two contiguous, pre-sorted ranges [leftBegin, mid) and
+ * [mid, rightEnd) into the range beginning at out, which must not overlap
+ * either input. Equal elements are taken from the left range first, so the
+ * merge is stable.
  * @param leftBegin iterator pointing to the first element of the 'left' range
  *              to be merged.
  * @param mid   iterator pointing to the mid-point of the combined 'left' and
  *              'right' ranges which is the past-the-end element for the 'left'
  *              range as well as the first element of the 'right' range.
- * @param rightEnd iterator pointing tothe past-the-end element for the 'right'
+ * @param rightEnd iterator pointing to the past-the-end element for the 'right'
  *              range.
+ * @param out   iterator pointing to the first element of a range of at least
+ *              rightEnd - leftBegin elements receiving the merged output.
  */ 
-template <typename RandomAccessIterator>
-unsigned long merge_halves(RandomAccessIterator leftBegin, RandomAccessIterator mid, RandomAccessIterator rightEnd)
+template <typename RandomAccessIterator, typename OutputIterator, typename Counter>
+void merge_into(RandomAccessIterator leftBegin, RandomAccessIterator mid, RandomAccessIterator rightEnd, OutputIterator out, Counter &comp)
 {
-    // Prepare temporary vector and left/right pointers
-    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
-    std::vector<value_type> temp;
     auto left = leftBegin;
     auto right = mid;
-    unsigned long comp = 0;
 
     // Compare left and right until either is exhausted
     while(left < mid && right < rightEnd)
     {
-        temp.push_back(*left < *right ? *(left++) : *(right++));
-        comp+=3;
+        *(out++) = *right < *left ? *(right++) : *(left++);
+        count_comparisons(comp, 3);
     }
 
     // Add any remaining elements
-    while(left < mid)
+    count_comparisons(comp, (mid - left) + (rightEnd - right));
+    count_moves(comp, rightEnd - leftBegin);
+    out = std::copy(left, mid, out);
+    std::copy(right, rightEnd, out);
+}
+
+/**
+ * Merges every pair of adjacent sorted runs of length width in [src, srcEnd)
+ * into the range beginning at dst. A trailing run without a partner is
+ * copied over unchanged.
+ */ 
+template <typename InputIterator, typename OutputIterator, typename Counter>
+void merge_pass(InputIterator src, InputIterator srcEnd, OutputIterator dst, std::ptrdiff_t width, Counter &comp)
+{
+    const std::ptrdiff_t size = srcEnd - src;
+    for (std::ptrdiff_t lo = 0; lo < size; lo += 2 * width)
     {
-        temp.push_back(*(left++));
-        comp++;
+        std::ptrdiff_t mid = std::min(lo + width, size);
+        std::ptrdiff_t hi = std::min(lo + 2 * width, size);
+        if (mid == hi)
+        {
+            std::copy(src + lo, src + hi, dst + lo);
+            count_moves(comp, hi - lo);
+        }
+        else merge_into(src + lo, src + mid, src + hi, dst + lo, comp);
     }
-    while(right < rightEnd)
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order using the
+ * caller's scratch memory, so repeated sorts can share one buffer.
+ * The order of equal elements is preserved.
+ * 
+ * Bottom-up merge sort: runs of width 1, 2, 4, ... are merged back and forth
+ * between the range and the buffer, so the sort neither recurses nor
+ * allocates.
+ * 
+ * @param begin  iterator pointing to the first element in the range to be
+ *               sorted, such as the iterator returned by std::vector::begin.
+ * @param end    iterator referring to the past-the-end element in the range
+ *               to be sorted, such as the iterator returned by std::vector::end.
+ * @param buffer iterator pointing to the first element of a scratch range of
+ *               at least end - begin elements.
+ */ 
+template <typename RandomAccessIterator, typename BufferIterator, typename Counter>
+void merge_sort(RandomAccessIterator begin, RandomAccessIterator end, BufferIterator buffer, Counter &comp)
+{
+    const std::ptrdiff_t size = end - begin;
+    if (size < 2) return;
+
+    bool in_buffer = false;
+    for (std::ptrdiff_t width = 1; width < size; width *= 2)
     {
-        temp.push_back(*(right++));
-        comp++;
+        if (in_buffer) merge_pass(buffer, buffer + size, begin, width, comp);
+        else merge_pass(begin, end, buffer, width, comp);
+        in_buffer = !in_buffer;
     }
 
-    // Copy temp into our original
-    for(int i = 0; i < temp.size(); i++)
+    if (in_buffer)
     {
-        *(leftBegin + i) = temp[i];
+        std::copy(buffer, buffer + size, begin);
+        count_moves(comp, size);
     }
-    return comp;
 }
 
+/**
+ * Whether T can be dereferenced, which tells the scratch buffer of
+ * merge_sort(begin, end, buffer) from the counter of
+ * merge_sort(begin, end, comp).
+ */
+template <typename T, typename = void>
+struct is_dereferenceable : std::false_type {};
+
+template <typename T>
+struct is_dereferenceable<T, decltype(void(*std::declval<T &>()))> : std::true_type {};
+
 /**
  * Sorts the elements in the range [begin, end) in ascending order. 
- * The order of equal elements is not guaranteed to be preserved.
- * Iterator must meet the requirements of ValueSwappable . The type 
- * of dereferenced RandomAccessIterator must be comparable with the
- *  < operator. 
+ * The order of equal elements is preserved.
+ * The type of dereferenced RandomAccessIterator must be comparable with the
+ * < operator. 
+ * 
+ * Allocates one scratch buffer of end - begin elements and runs the
+ * bottom-up merge sort above.
  * 
  * @param begin iterator pointing to the first element in the range to be
  *              sorted, such as the iterator returned by std::vector::begin.
  * @param end   iterator referring to the past-the-end element in the range to
  *              be sorted, such as the iterator returned by std::vector::end.
  */ 
-template <typename RandomAccessIterator>
-void merge_sort(RandomAccessIterator begin, RandomAccessIterator end, unsigned long &comp)
+template <typename RandomAccessIterator, typename Counter>
+typename std::enable_if<!is_dereferenceable<Counter>::value>::type
+merge_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+    if (end - begin < 2) return;
+
+    std::vector<value_type> buffer(begin, end);
+    merge_sort(begin, end, buffer.begin(), comp);
+}
+
+/**
+ * Ranges at or below this size are sorted by a single task of
+ * parallel_merge_sort.
+ */
+constexpr std::ptrdiff_t PARALLEL_MERGE_SORT_GRAIN = 4096;
+
+/**
+ * Sorts [begin, end) as one task of parallel_merge_sort. Operations are
+ * counted into a Counter local to the task and added to the shared total
+ * once at the end.
+ */ 
+template <typename RandomAccessIterator, typename BufferIterator, typename Counter>
+void parallel_merge_sort_task(WorkStealingPool &pool, RandomAccessIterator begin, RandomAccessIterator end,
+                              BufferIterator buffer, std::ptrdiff_t grain, AtomicOpCounter &total)
 {
     auto size = end - begin;
-    if (size < 2) return;
+    Counter local = Counter();
+
+    if (size <= grain)
+    {
+        merge_sort(begin, end, buffer, local);
+        add_counts(total, local);
+        return;
+    }
 
     auto mid = begin + (size / 2);
 
-    // use recursion to sort each half
-    merge_sort(begin, mid, comp);
-    merge_sort(mid, end, comp);
+    // Offer the left half to thieves and sort the right half ourselves
+    std::atomic<std::size_t> pending(1);
+    pool.submit([&pool, begin, mid, buffer, grain, &total, &pending]() {
+        parallel_merge_sort_task<RandomAccessIterator, BufferIterator, Counter>(pool, begin, mid, buffer, grain, total);
+        pending--;
+    });
+    parallel_merge_sort_task<RandomAccessIterator, BufferIterator, Counter>(pool, mid, end, buffer + (size / 2), grain, total);
+    pool.wait(pending);
+
+    merge_into(begin, mid, end, buffer, local);
+    std::copy(buffer, buffer + size, begin);
+    count_moves(local, size);
+    add_counts(total, local);
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order using
+ * num_threads threads. The range is halved recursively down to
+ * PARALLEL_MERGE_SORT_GRAIN elements, every half is a task on a
+ * work-stealing pool, and the leaves are sorted by merge_sort. All merges go
+ * through one scratch buffer allocated up front. Every task counts into a
+ * local total that is added once, so the comparison count is the same for
+ * any number of threads.
+ * 
+ * @param begin iterator pointing to the first element in the range to be
+ *              sorted, such as the iterator returned by std::vector::begin.
+ * @param end   iterator referring to the past-the-end element in the range to
+ *              be sorted, such as the iterator returned by std::vector::end.
+ * @param num_threads number of threads to sort with, including the caller.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void parallel_merge_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp, unsigned num_threads)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+    auto size = end - begin;
+    if (size < 2) return;
+
+    std::vector<value_type> buffer(begin, end);
+
+    if (size <= PARALLEL_MERGE_SORT_GRAIN)
+    {
+        merge_sort(begin, end, buffer.begin(), comp);
+        return;
+    }
+
+    // The task tree depends only on size, which keeps the counts independent
+    // of the number of threads
+    AtomicOpCounter total;
+
+    WorkStealingPool &pool = thread_pool_for(num_threads);
+    parallel_merge_sort_task<RandomAccessIterator, typename std::vector<value_type>::iterator, Counter>(
+        pool, begin, end, buffer.begin(), PARALLEL_MERGE_SORT_GRAIN, total);
+    add_counts(comp, total);
+}
 
-    // merge the two sorted halves
-    comp+=merge_halves(begin, mid, end);
+/**
+ * Sorts the elements in the range [begin, end) in ascending order using every
+ * hardware thread. See parallel_merge_sort above.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void parallel_merge_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    parallel_merge_sort(begin, end, comp, default_thread_count());
 }
 
 
@@ -195,27 +401,28 @@ void merge_sort(RandomAccessIterator begin, RandomAccessIterator end, unsigned l
  * @param high last index of range
  */ 
 
-template <typename RandomAccessIterator>
-RandomAccessIterator partition(RandomAccessIterator lo, RandomAccessIterator hi, unsigned long &comp)
+template <typename RandomAccessIterator, typename Counter>
+RandomAccessIterator partition(RandomAccessIterator lo, RandomAccessIterator hi, Counter &comp)
 {
     auto pivot = *hi;
-    RandomAccessIterator i = lo - 1;
+    // Next slot for an element not above the pivot
+    RandomAccessIterator i = lo;
 
     for (auto j = lo; j < hi; ++j)
     {
         if (*j <= pivot) {
+            exch(i, j, comp);
             ++i;
-            exch(i, j);
         }
-        comp++;
+        count_comparisons(comp);
     }
-    exch(i + 1, hi);
-    return i + 1;
+    exch(i, hi, comp);
+    return i;
 }
 
 
-template <typename RandomAccessIterator>
-RandomAccessIterator hoare_partition(RandomAccessIterator lo, RandomAccessIterator hi, unsigned long &comp) 
+template <typename RandomAccessIterator, typename Counter>
+RandomAccessIterator hoare_partition(RandomAccessIterator lo, RandomAccessIterator hi, Counter &comp) 
 {
     RandomAccessIterator i = lo;
     RandomAccessIterator j = hi + 1;
@@ -225,29 +432,30 @@ RandomAccessIterator hoare_partition(RandomAccessIterator lo, RandomAccessIterat
     {
         while (*(++i) < pivot)
         {
-            comp++;
+            count_comparisons(comp);
             if (i == hi) break;
         }
         while (pivot < *(--j))
         {
-            comp++;
+            count_comparisons(comp);
             if (j == lo) break;
         }
-        comp++;
+        count_comparisons(comp);
         if (i >= j) break;
-        exch(i, j);
+        exch(i, j, comp);
     }
-    exch(lo, j);
+    exch(lo, j, comp);
     return j;
 }
 
-template <typename RandomAccessIterator>
-RandomAccessIterator randomized_partition(RandomAccessIterator lo, RandomAccessIterator hi, unsigned long &comp) 
+template <typename RandomAccessIterator, typename Counter>
+RandomAccessIterator randomized_partition(RandomAccessIterator lo, RandomAccessIterator hi, Counter &comp) 
 {
     int range  = std::distance(lo, hi);
     int offset = std::rand() % range;
-    exch(lo + offset, hi);
-    return partition(lo, hi, comp);
+    exch(lo + offset, hi, comp);
+    // Qualified so ADL cannot pick std::partition for a generic Counter
+    return ::partition(lo, hi, comp);
 }
 
 
@@ -261,39 +469,39 @@ RandomAccessIterator randomized_partition(RandomAccessIterator lo, RandomAccessI
  * 
  * @param high last index
  */ 
-template <typename RandomAccessIterator>
-void quick_sort(RandomAccessIterator begin, RandomAccessIterator end, unsigned long &comp)
+template <typename RandomAccessIterator, typename Counter>
+void quick_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
 {
     if (end <= begin) return;  
     
-    RandomAccessIterator p = partition(begin, end, comp);
+    RandomAccessIterator p = ::partition(begin, end, comp);
 
     // Quick sort on left and right of partition
-    quick_sort(begin, p - 1, comp);
+    if (p > begin) quick_sort(begin, p - 1, comp);
     quick_sort(p + 1, end, comp);
 }
 
-template <typename RandomAccessIterator>
-void hoare_quick_sort(RandomAccessIterator begin, RandomAccessIterator end, unsigned long &comp)
+template <typename RandomAccessIterator, typename Counter>
+void hoare_quick_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
 {
     if (end <= begin) return;  
     
     RandomAccessIterator p = hoare_partition(begin, end, comp);
 
     // Quick sort on left and right of partition
-    hoare_quick_sort(begin, p - 1, comp);
+    if (p > begin) hoare_quick_sort(begin, p - 1, comp);
     hoare_quick_sort(p + 1, end, comp);
 }
 
-template <typename RandomAccessIterator>
-void randomized_quick_sort(RandomAccessIterator begin, RandomAccessIterator end, unsigned long &comp)
+template <typename RandomAccessIterator, typename Counter>
+void randomized_quick_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
 {
     if (end <= begin) return;  
     
     RandomAccessIterator p = randomized_partition(begin, end, comp);
 
     // Quick sort on left and right of partition
-    randomized_quick_sort(begin, p - 1, comp);
+    if (p > begin) randomized_quick_sort(begin, p - 1, comp);
     randomized_quick_sort(p + 1, end, comp);
 }
 
@@ -307,15 +515,15 @@ void randomized_quick_sort(RandomAccessIterator begin, RandomAccessIterator end,
  * 
  * @param n size of heap
  */ 
-template <typename RandomAccessIterator>
-void heapify(RandomAccessIterator begin, int i, int n, unsigned long &comp)
+template <typename RandomAccessIterator, typename Counter>
+void heapify(RandomAccessIterator begin, int i, int n, Counter &comp)
 {
     // Get left and right child based on 0-index
     int l = (2 * i) + 1;
     int r = (2 * i) + 2;
     int largest = i;
 
-    comp += 3;
+    count_comparisons(comp, 3);
 
     if((l < n) && (*(begin + l) > *(begin + largest))) largest = l;
     if((r < n) && (*(begin + r) > *(begin + largest))) largest = r;
@@ -323,7 +531,7 @@ void heapify(RandomAccessIterator begin, int i, int n, unsigned long &comp)
     if(largest != i)
     {
         // swap the values at i and largest, then restore heap invariant.
-        exch(begin + i, begin + largest);
+        exch(begin + i, begin + largest, comp);
         heapify(begin, largest, n, comp);
     }
 }
@@ -334,8 +542,8 @@ void heapify(RandomAccessIterator begin, int i, int n, unsigned long &comp)
  * 
  * @param vec pointer to vector<T> to be sorted.
  */ 
-template <typename RandomAccessIterator>
-void heap_sort(RandomAccessIterator begin, RandomAccessIterator end, unsigned long &comp)
+template <typename RandomAccessIterator, typename Counter>
+void heap_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
 {
     if (begin == end) return;
 
@@ -347,9 +555,2048 @@ void heap_sort(RandomAccessIterator begin, RandomAccessIterator end, unsigned lo
 
     for(int i = heapSize - 1; i > 0; --i)
     {
-        exch(begin, begin + i);
+        exch(begin, begin + i, comp);
         heapify(begin, 0, i, comp);
     }
 }
 
-#endif
\ No newline at end of file
+/**
+ * Ranges at or below this size are left for small_sort by intro_sort.
+ */
+constexpr std::ptrdiff_t INTRO_SORT_THRESHOLD = 16;
+
+/**
+ * Returns floor(log2(n)) for n > 0.
+ */
+inline int floor_log2(std::ptrdiff_t n)
+{
+    int k = 0;
+    for (; n > 1; n >>= 1) ++k;
+    return k;
+}
+
+/**
+ * Moves the median of *a, *b and *c into *result.
+ * 
+ * @param result iterator receiving the median, must not alias a, b or c.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void move_median_to_first(RandomAccessIterator result, RandomAccessIterator a,
+                          RandomAccessIterator b, RandomAccessIterator c, Counter &comp)
+{
+    count_comparisons(comp, 2);
+    if (*a < *b)
+    {
+        if (*b < *c) exch(result, b, comp);
+        else if (count_comparisons(comp), *a < *c) exch(result, c, comp);
+        else exch(result, a, comp);
+    }
+    else if (*a < *c) exch(result, a, comp);
+    else if (count_comparisons(comp), *b < *c) exch(result, c, comp);
+    else exch(result, b, comp);
+}
+
+/**
+ * Partitions [begin, end) around the median of its first, middle and last
+ * elements. The pivot is parked at begin so the median-of-three guarantees
+ * a sentinel on both sides and the inner scans need no bounds checks.
+ * 
+ * Returns the cut such that every element of [begin, cut) is <= the pivot
+ * and every element of [cut, end) is >= the pivot.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+RandomAccessIterator median_of_three_partition(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    auto mid = begin + (end - begin) / 2;
+    move_median_to_first(begin, begin + 1, mid, end - 1, comp);
+
+    auto lo = begin + 1;
+    auto hi = end;
+    while (true)
+    {
+        while (count_comparisons(comp), *lo < *begin) ++lo;
+        --hi;
+        while (count_comparisons(comp), *begin < *hi) --hi;
+        if (!(lo < hi)) return lo;
+        exch(lo, hi, comp);
+        ++lo;
+    }
+}
+
+template <typename RandomAccessIterator, typename Counter>
+void intro_sort_loop(RandomAccessIterator begin, RandomAccessIterator end, int depth_limit, Counter &comp)
+{
+    while (end - begin > INTRO_SORT_THRESHOLD)
+    {
+        // Too many bad pivots, fall back to the O(n log n) worst case of heap sort
+        if (depth_limit == 0)
+        {
+            heap_sort(begin, end, comp);
+            return;
+        }
+        --depth_limit;
+
+        auto cut = median_of_three_partition(begin, end, comp);
+
+        // Recurse into the smaller side and loop on the larger one so the
+        // stack never grows past log2(n) frames.
+        if (cut - begin < end - cut)
+        {
+            intro_sort_loop(begin, cut, depth_limit, comp);
+            begin = cut;
+        }
+        else
+        {
+            intro_sort_loop(cut, end, depth_limit, comp);
+            end = cut;
+        }
+    }
+    small_sort(begin, end, comp);
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order. 
+ * The order of equal elements is not guaranteed to be preserved.
+ * Iterators must meet the requirements of ValueSwappable. The type of
+ * dereferenced RandomAccessIterator must be comparable with the < and >
+ * operators. 
+ * 
+ * Quick sort with median-of-three pivots that switches to heap_sort once the
+ * recursion depth exceeds 2*log2(n) and finishes ranges of at most
+ * INTRO_SORT_THRESHOLD elements with small_sort, giving an O(n log n)
+ * worst case.
+ * 
+ * @param begin iterator pointing to the first element in the range to be
+ *              sorted, such as the iterator returned by std::vector::begin.
+ * @param end   iterator referring to the past-the-end element in the range to
+ *              be sorted, such as the iterator returned by std::vector::end.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void intro_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    if (end - begin < 2) return;
+
+    intro_sort_loop(begin, end, 2 * floor_log2(end - begin), comp);
+}
+
+/**
+ * Scatters the n elements starting at src into dst by the 8-bit digit of
+ * their key at shift, advancing offsets[digit] for every element written.
+ */ 
+template <typename InputIterator, typename OutputIterator, typename Key>
+void radix_scatter(InputIterator src, std::size_t n, OutputIterator dst, std::size_t offsets[256], int shift, Key sign_flip)
+{
+    for (std::size_t i = 0; i < n; ++i, ++src)
+    {
+        Key key = static_cast<Key>(*src) ^ sign_flip;
+        *(dst + offsets[(key >> shift) & 0xFF]++) = *src;
+    }
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order. 
+ * The order of equal elements is preserved.
+ * The type of dereferenced RandomAccessIterator must be integral.
+ * 
+ * Least-significant-digit radix sort on 8-bit digits. One pass over the input
+ * builds the histograms of every digit at once, then each digit is scattered
+ * between the range and a scratch buffer. Digits on which every key agrees
+ * are skipped. comp counts one operation per element per pass over the data.
+ * 
+ * @param begin iterator pointing to the first element in the range to be
+ *              sorted, such as the iterator returned by std::vector::begin.
+ * @param end   iterator referring to the past-the-end element in the range to
+ *              be sorted, such as the iterator returned by std::vector::end.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void lsd_radix_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    static_assert(std::is_integral<value_type>::value, "lsd_radix_sort requires an integral value type");
+    typedef typename std::make_unsigned<value_type>::type key_type;
+
+    const std::size_t size = end - begin;
+    if (size < 2) return;
+
+    constexpr int DIGITS = sizeof(value_type);
+
+    // Flipping the sign bit orders negative keys before positive ones
+    const key_type sign_flip = std::is_signed<value_type>::value
+        ? static_cast<key_type>(key_type(1) << (8 * sizeof(value_type) - 1)) : key_type(0);
+
+    std::size_t counts[DIGITS][256] = {};
+    for (auto it = begin; it != end; ++it)
+    {
+        key_type key = static_cast<key_type>(*it) ^ sign_flip;
+        for (int d = 0; d < DIGITS; ++d)
+            counts[d][(key >> (8 * d)) & 0xFF]++;
+    }
+    count_comparisons(comp, size);
+
+    std::vector<value_type> buffer(size);
+    bool in_buffer = false;
+    const key_type first = static_cast<key_type>(*begin) ^ sign_flip;
+
+    for (int d = 0; d < DIGITS; ++d)
+    {
+        const int shift = 8 * d;
+
+        // Every key falls in one bucket, the pass would be a plain copy
+        if (counts[d][(first >> shift) & 0xFF] == size) continue;
+
+        std::size_t offsets[256];
+        std::size_t sum = 0;
+        for (int b = 0; b < 256; ++b)
+        {
+            offsets[b] = sum;
+            sum += counts[d][b];
+        }
+
+        if (in_buffer) radix_scatter(buffer.begin(), size, begin, offsets, shift, sign_flip);
+        else radix_scatter(begin, size, buffer.begin(), offsets, shift, sign_flip);
+        in_buffer = !in_buffer;
+        count_comparisons(comp, size);
+        count_moves(comp, size);
+    }
+
+    if (in_buffer)
+    {
+        std::copy(buffer.begin(), buffer.end(), begin);
+        count_moves(comp, size);
+    }
+}
+
+/**
+ * Tuning constants of block_quick_sort: ranges below the insertion threshold
+ * are finished by small_sort, ranges above the ninther threshold choose
+ * their pivot as the median of three medians, and each side of the partition
+ * buffers the outcome of BLOCK_PARTITION_SIZE comparisons at a time.
+ */
+constexpr std::ptrdiff_t BLOCK_QUICK_SORT_INSERTION_THRESHOLD = 24;
+constexpr std::ptrdiff_t BLOCK_QUICK_SORT_NINTHER_THRESHOLD = 128;
+constexpr std::size_t BLOCK_PARTITION_SIZE = 64;
+
+/**
+ * Orders the three elements so that *a <= *b <= *c.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void sort3(RandomAccessIterator a, RandomAccessIterator b, RandomAccessIterator c, Counter &comp)
+{
+    count_comparisons(comp, 3);
+    if (*b < *a) exch(a, b, comp);
+    if (*c < *b) exch(b, c, comp);
+    if (*b < *a) exch(a, b, comp);
+}
+
+/**
+ * Insertion sort that gives up once more than 8 elements have been moved.
+ * Returns whether [begin, end) ended up sorted.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+bool partial_insertion_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    if (begin == end) return true;
+
+    std::ptrdiff_t moved = 0;
+    for (auto i = begin + 1; i != end; ++i)
+    {
+        count_comparisons(comp);
+        if (*i < *(i - 1))
+        {
+            auto key = *i;
+            auto j = i;
+            do {
+                *j = *(j - 1);
+                --j;
+            } while (j != begin && (count_comparisons(comp), key < *(j - 1)));
+            *j = key;
+            moved += i - j;
+            count_moves(comp, (i - j) + 2);
+        }
+        if (moved > 8) return false;
+    }
+    return true;
+}
+
+/**
+ * Swaps the num elements first + offsets_l[i] with last - offsets_r[i]. When
+ * the counts differ the swaps are done as one cyclic rotation, which needs
+ * about a third fewer moves than independent swaps.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void swap_offsets(RandomAccessIterator first, RandomAccessIterator last,
+                  unsigned char const *offsets_l, unsigned char const *offsets_r,
+                  std::size_t num, bool use_swaps, Counter &comp)
+{
+    if (use_swaps)
+    {
+        for (std::size_t i = 0; i < num; ++i)
+            exch(first + offsets_l[i], last - offsets_r[i], comp);
+    }
+    else if (num > 0)
+    {
+        auto l = first + offsets_l[0];
+        auto r = last - offsets_r[0];
+        auto tmp = *l;
+        *l = *r;
+        for (std::size_t i = 1; i < num; ++i)
+        {
+            l = first + offsets_l[i];
+            *r = *l;
+            r = last - offsets_r[i];
+            *l = *r;
+        }
+        *r = tmp;
+        count_moves(comp, 2 * num + 1);
+    }
+}
+
+/**
+ * Partitions [begin, end) around the pivot *begin without data-dependent
+ * branches (BlockQuicksort). Each side records the offsets of misplaced
+ * elements for a whole block by adding the comparison result to a counter,
+ * then the recorded pairs are swapped in one go. Elements equal to the pivot
+ * go to the right.
+ * 
+ * Returns the final position of the pivot. already_partitioned is set when
+ * no element had to be moved.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+RandomAccessIterator block_partition(RandomAccessIterator begin, RandomAccessIterator end,
+                                     bool &already_partitioned, Counter &comp)
+{
+    const std::size_t B = BLOCK_PARTITION_SIZE;
+    auto pivot = *begin;
+    auto first = begin;
+    auto last = end;
+
+    // The median-of-three guarantees a sentinel on both sides
+    while (count_comparisons(comp), *++first < pivot);
+    if (first - 1 == begin) while (first < last && (count_comparisons(comp), !(*--last < pivot)));
+    else                    while (count_comparisons(comp), !(*--last < pivot));
+
+    already_partitioned = first >= last;
+    if (!already_partitioned)
+    {
+        exch(first, last, comp);
+        ++first;
+
+        alignas(64) unsigned char offsets_l[B];
+        alignas(64) unsigned char offsets_r[B];
+        std::size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+        while (static_cast<std::size_t>(last - first) > 2 * B)
+        {
+            if (num_l == 0)
+            {
+                start_l = 0;
+                auto it = first;
+                for (std::size_t i = 0; i < B; ++i, ++it)
+                {
+                    offsets_l[num_l] = static_cast<unsigned char>(i);
+                    num_l += !(*it < pivot);
+                }
+                count_comparisons(comp, B);
+            }
+            if (num_r == 0)
+            {
+                start_r = 0;
+                auto it = last;
+                for (std::size_t i = 0; i < B; ++i)
+                {
+                    offsets_r[num_r] = static_cast<unsigned char>(i + 1);
+                    num_r += *--it < pivot;
+                }
+                count_comparisons(comp, B);
+            }
+
+            std::size_t num = std::min(num_l, num_r);
+            swap_offsets(first, last, offsets_l + start_l, offsets_r + start_r, num, num_l == num_r, comp);
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+            if (num_l == 0) first += B;
+            if (num_r == 0) last -= B;
+        }
+
+        // Split the remaining unknown elements between the two sides
+        std::size_t l_size, r_size;
+        std::size_t unknown = static_cast<std::size_t>(last - first) - ((num_l || num_r) ? B : 0);
+        if (num_r)
+        {
+            l_size = unknown;
+            r_size = B;
+        }
+        else if (num_l)
+        {
+            l_size = B;
+            r_size = unknown;
+        }
+        else
+        {
+            l_size = unknown / 2;
+            r_size = unknown - l_size;
+        }
+
+        if (unknown && !num_l)
+        {
+            start_l = 0;
+            auto it = first;
+            for (std::size_t i = 0; i < l_size; ++i, ++it)
+            {
+                offsets_l[num_l] = static_cast<unsigned char>(i);
+                num_l += !(*it < pivot);
+            }
+            count_comparisons(comp, l_size);
+        }
+        if (unknown && !num_r)
+        {
+            start_r = 0;
+            auto it = last;
+            for (std::size_t i = 0; i < r_size; ++i)
+            {
+                offsets_r[num_r] = static_cast<unsigned char>(i + 1);
+                num_r += *--it < pivot;
+            }
+            count_comparisons(comp, r_size);
+        }
+
+        std::size_t num = std::min(num_l, num_r);
+        swap_offsets(first, last, offsets_l + start_l, offsets_r + start_r, num, num_l == num_r, comp);
+        num_l -= num;
+        num_r -= num;
+        start_l += num;
+        start_r += num;
+        if (num_l == 0) first += l_size;
+        if (num_r == 0) last -= r_size;
+
+        // One side still holds misplaced elements, move them past the other
+        if (num_l)
+        {
+            while (num_l--) exch(first + offsets_l[start_l + num_l], --last, comp);
+            first = last;
+        }
+        if (num_r)
+        {
+            while (num_r--) exch(last - offsets_r[start_r + num_r], first++, comp);
+            last = first;
+        }
+    }
+
+    auto pivot_pos = first - 1;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+    count_moves(comp, 3);
+    return pivot_pos;
+}
+
+/**
+ * Partitions [begin, end) so that elements equal to the pivot *begin go to
+ * the left. Used when the pivot equals the element preceding the range,
+ * which means every element of the range is >= pivot and the left side will
+ * contain only copies of it.
+ * 
+ * Returns the final position of the pivot.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+RandomAccessIterator partition_equal_left(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    auto pivot = *begin;
+    auto first = begin;
+    auto last = end;
+
+    while (count_comparisons(comp), pivot < *--last);
+    if (last + 1 == end) while (first < last && (count_comparisons(comp), !(pivot < *++first)));
+    else                 while (count_comparisons(comp), !(pivot < *++first));
+
+    while (first < last)
+    {
+        exch(first, last, comp);
+        while (count_comparisons(comp), pivot < *--last);
+        while (count_comparisons(comp), !(pivot < *++first));
+    }
+
+    *begin = *last;
+    *last = pivot;
+    count_moves(comp, 3);
+    return last;
+}
+
+/**
+ * Swaps a few elements of a side left too small by a bad partition with
+ * elements a quarter of the way in, breaking up patterns such as sorted
+ * runs or organ pipes that fool the median-of-three.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void break_patterns(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    auto size = end - begin;
+    if (size < BLOCK_QUICK_SORT_INSERTION_THRESHOLD) return;
+
+    exch(begin, begin + size / 4, comp);
+    exch(end - 1, end - size / 4, comp);
+    if (size > BLOCK_QUICK_SORT_NINTHER_THRESHOLD)
+    {
+        exch(begin + 1, begin + (size / 4 + 1), comp);
+        exch(begin + 2, begin + (size / 4 + 2), comp);
+        exch(end - 2, end - (size / 4 + 1), comp);
+        exch(end - 3, end - (size / 4 + 2), comp);
+    }
+}
+
+template <typename RandomAccessIterator, typename Counter>
+void block_quick_sort_loop(RandomAccessIterator begin, RandomAccessIterator end, int bad_allowed, bool leftmost, Counter &comp)
+{
+    while (true)
+    {
+        auto size = end - begin;
+        if (size < BLOCK_QUICK_SORT_INSERTION_THRESHOLD)
+        {
+            small_sort(begin, end, comp);
+            return;
+        }
+
+        // Pivot goes to begin, as the median of three or of three medians
+        auto half = size / 2;
+        if (size > BLOCK_QUICK_SORT_NINTHER_THRESHOLD)
+        {
+            sort3(begin, begin + half, end - 1, comp);
+            sort3(begin + 1, begin + (half - 1), end - 2, comp);
+            sort3(begin + 2, begin + (half + 1), end - 3, comp);
+            sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+            exch(begin, begin + half, comp);
+        }
+        else sort3(begin + half, begin, end - 1, comp);
+
+        // The pivot equals the element before the range: gather its copies on
+        // the left and never look at them again
+        if (!leftmost && (count_comparisons(comp), !(*(begin - 1) < *begin)))
+        {
+            begin = partition_equal_left(begin, end, comp) + 1;
+            continue;
+        }
+
+        bool already_partitioned;
+        auto pivot_pos = block_partition(begin, end, already_partitioned, comp);
+
+        auto l_size = pivot_pos - begin;
+        auto r_size = end - (pivot_pos + 1);
+
+        if (l_size < size / 8 || r_size < size / 8)
+        {
+            // Too many bad partitions, fall back to the O(n log n) worst case
+            if (--bad_allowed == 0)
+            {
+                heap_sort(begin, end, comp);
+                return;
+            }
+            break_patterns(begin, pivot_pos, comp);
+            break_patterns(pivot_pos + 1, end, comp);
+        }
+        else if (already_partitioned
+                 && partial_insertion_sort(begin, pivot_pos, comp)
+                 && partial_insertion_sort(pivot_pos + 1, end, comp))
+        {
+            // The input looked sorted and a cheap insertion pass confirmed it
+            return;
+        }
+
+        block_quick_sort_loop(begin, pivot_pos, bad_allowed, leftmost, comp);
+        begin = pivot_pos + 1;
+        leftmost = false;
+    }
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order. 
+ * The order of equal elements is not guaranteed to be preserved.
+ * Iterators must meet the requirements of ValueSwappable. The type of
+ * dereferenced RandomAccessIterator must be comparable with the < and >
+ * operators. 
+ * 
+ * Pattern-defeating quick sort with branchless block partitioning. Bad
+ * partitions shuffle the input and, after log2(n) of them, hand the range to
+ * heap_sort. Runs of keys equal to an earlier pivot are partitioned away
+ * in linear time and sorted-looking partitions are finished by a bounded
+ * insertion sort.
+ * 
+ * @param begin iterator pointing to the first element in the range to be
+ *              sorted, such as the iterator returned by std::vector::begin.
+ * @param end   iterator referring to the past-the-end element in the range to
+ *              be sorted, such as the iterator returned by std::vector::end.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void block_quick_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    if (end - begin < 2) return;
+
+    block_quick_sort_loop(begin, end, floor_log2(end - begin), true, comp);
+}
+
+/**
+ * Tuning constants of tim_sort: inputs shorter than TIM_SORT_MIN_MERGE are
+ * sorted by a single binary insertion sort, and TIM_SORT_MIN_GALLOP is the
+ * initial number of consecutive wins by one run that switches a merge into
+ * galloping mode.
+ */
+constexpr std::ptrdiff_t TIM_SORT_MIN_MERGE = 32;
+constexpr int TIM_SORT_MIN_GALLOP = 7;
+
+/**
+ * Returns the position of the boundary in [first, last), which must be
+ * partitioned by before (all true, then all false). The boundary is found
+ * by probing 1, 3, 7, 15, ... elements from the chosen end followed by a
+ * binary search, so a boundary k elements from that end costs O(log k).
+ */ 
+template <typename RandomAccessIterator, typename Predicate>
+RandomAccessIterator gallop(RandomAccessIterator first, RandomAccessIterator last, Predicate before, bool from_right)
+{
+    std::ptrdiff_t n = last - first, prev = 0, ofs = 1;
+    if (!from_right)
+    {
+        while (ofs <= n && before(first[ofs - 1]))
+        {
+            prev = ofs;
+            ofs = 2 * ofs + 1;
+        }
+        return std::partition_point(first + prev, first + std::min(ofs - 1, n), before);
+    }
+    while (ofs <= n && !before(last[-ofs]))
+    {
+        prev = ofs;
+        ofs = 2 * ofs + 1;
+    }
+    return std::partition_point(last - std::min(ofs - 1, n), last - prev, before);
+}
+
+/**
+ * Returns the length of the run starting at begin. A strictly descending run
+ * is reversed in place, so the run is ascending afterwards. Requiring strict
+ * descent keeps the reversal stable.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+std::ptrdiff_t count_run_and_make_ascending(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    auto run_end = begin + 1;
+    if (run_end == end) return 1;
+
+    count_comparisons(comp);
+    if (*run_end < *begin)
+    {
+        ++run_end;
+        while (run_end < end && (count_comparisons(comp), *run_end < *(run_end - 1))) ++run_end;
+        std::reverse(begin, run_end);
+        count_moves(comp, 3 * ((run_end - begin) / 2));
+    }
+    else
+    {
+        ++run_end;
+        while (run_end < end && (count_comparisons(comp), !(*run_end < *(run_end - 1)))) ++run_end;
+    }
+    return run_end - begin;
+}
+
+/**
+ * Extends the sorted range [begin, start) to [begin, end) by inserting each
+ * element after the last element not greater than it, found by binary search.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void binary_insertion_sort(RandomAccessIterator begin, RandomAccessIterator start, RandomAccessIterator end, Counter &comp)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+    for (auto i = start; i < end; ++i)
+    {
+        value_type key = *i;
+        auto pos = std::upper_bound(begin, i, key, [&comp](value_type const &a, value_type const &b) {
+            count_comparisons(comp);
+            return a < b;
+        });
+        count_moves(comp, (i - pos) + 2);
+        std::copy_backward(pos, i, i + 1);
+        *pos = key;
+    }
+}
+
+/**
+ * Returns the minimum run length for an input of n elements: n itself when
+ * n < TIM_SORT_MIN_MERGE, otherwise a length in [16, 32] chosen so that
+ * n / length is a power of two or slightly below one.
+ */
+inline std::ptrdiff_t tim_sort_min_run(std::ptrdiff_t n)
+{
+    std::ptrdiff_t r = 0;
+    while (n >= TIM_SORT_MIN_MERGE)
+    {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+/**
+ * Merges the adjacent runs [a, b) and [b, b_end) where [a, b) is the shorter
+ * one. The left run is copied to tmp and the merge fills the range from the
+ * left. After min_gallop consecutive wins by one side the merge gallops
+ * through that side, and min_gallop adapts to how well galloping pays off.
+ */ 
+template <typename RandomAccessIterator, typename T, typename Counter>
+void tim_sort_merge_lo(RandomAccessIterator a, RandomAccessIterator b, RandomAccessIterator b_end,
+                       std::vector<T> &tmp, int &min_gallop, Counter &comp)
+{
+    tmp.assign(a, b);
+    auto left = tmp.begin(), left_end = tmp.end();
+    auto right = b;
+    auto dest = a;
+
+    while (left != left_end && right != b_end)
+    {
+        int left_wins = 0, right_wins = 0;
+        do {
+            count_comparisons(comp);
+            if (*right < *left)
+            {
+                *(dest++) = *(right++);
+                right_wins++;
+                left_wins = 0;
+            }
+            else
+            {
+                *(dest++) = *(left++);
+                left_wins++;
+                right_wins = 0;
+            }
+        } while (left != left_end && right != b_end && left_wins < min_gallop && right_wins < min_gallop);
+
+        while (left != left_end && right != b_end)
+        {
+            // Everything in left not greater than *right goes first
+            T const &pivot = *right;
+            auto k = gallop(left, left_end, [&comp, &pivot](T const &x) { count_comparisons(comp); return !(pivot < x); }, false);
+            left_wins = static_cast<int>(k - left);
+            dest = std::copy(left, k, dest);
+            left = k;
+            if (left == left_end) break;
+            *(dest++) = *(right++);
+            if (right == b_end) break;
+
+            // Everything in right less than *left goes next
+            T const &key = *left;
+            auto j = gallop(right, b_end, [&comp, &key](T const &x) { count_comparisons(comp); return x < key; }, false);
+            right_wins = static_cast<int>(j - right);
+            dest = std::copy(right, j, dest);
+            right = j;
+            if (right == b_end) break;
+            *(dest++) = *(left++);
+
+            if (min_gallop > 1) min_gallop--;
+            if (left_wins < TIM_SORT_MIN_GALLOP && right_wins < TIM_SORT_MIN_GALLOP)
+            {
+                min_gallop += 2;
+                break;
+            }
+        }
+    }
+
+    // Any rest of the right run is already in place
+    std::copy(left, left_end, dest);
+    count_moves(comp, (b - a) + (right - a));
+}
+
+/**
+ * Mirror image of tim_sort_merge_lo for the case where the right run
+ * [b, b_end) is the shorter one: the right run is copied to tmp and the
+ * merge fills the range from the right.
+ */ 
+template <typename RandomAccessIterator, typename T, typename Counter>
+void tim_sort_merge_hi(RandomAccessIterator a, RandomAccessIterator b, RandomAccessIterator b_end,
+                       std::vector<T> &tmp, int &min_gallop, Counter &comp)
+{
+    tmp.assign(b, b_end);
+    auto left = b;
+    auto right_begin = tmp.begin(), right = tmp.end();
+    auto dest = b_end;
+
+    while (left != a && right != right_begin)
+    {
+        int left_wins = 0, right_wins = 0;
+        do {
+            count_comparisons(comp);
+            if (*(right - 1) < *(left - 1))
+            {
+                *(--dest) = *(--left);
+                left_wins++;
+                right_wins = 0;
+            }
+            else
+            {
+                *(--dest) = *(--right);
+                right_wins++;
+                left_wins = 0;
+            }
+        } while (left != a && right != right_begin && left_wins < min_gallop && right_wins < min_gallop);
+
+        while (left != a && right != right_begin)
+        {
+            // Everything in left greater than the last of right goes last
+            T const &pivot = *(right - 1);
+            auto k = gallop(a, left, [&comp, &pivot](T const &x) { count_comparisons(comp); return !(pivot < x); }, true);
+            left_wins = static_cast<int>(left - k);
+            dest = std::copy_backward(k, left, dest);
+            left = k;
+            if (left == a) break;
+            *(--dest) = *(--right);
+            if (right == right_begin) break;
+
+            // Everything in right not less than the last of left goes next
+            T const &key = *(left - 1);
+            auto j = gallop(right_begin, right, [&comp, &key](T const &x) { count_comparisons(comp); return x < key; }, true);
+            right_wins = static_cast<int>(right - j);
+            dest = std::copy_backward(j, right, dest);
+            right = j;
+            if (right == right_begin) break;
+            *(--dest) = *(--left);
+
+            if (min_gallop > 1) min_gallop--;
+            if (left_wins < TIM_SORT_MIN_GALLOP && right_wins < TIM_SORT_MIN_GALLOP)
+            {
+                min_gallop += 2;
+                break;
+            }
+        }
+    }
+
+    // Any rest of the left run is already in place
+    std::copy_backward(right_begin, right, dest);
+    count_moves(comp, (b_end - b) + (b_end - left));
+}
+
+/**
+ * Merges the adjacent runs [a, b) and [b, b_end). Elements at the start of
+ * the left run and at the end of the right run that are already in their
+ * final place are skipped by galloping before anything is copied.
+ */ 
+template <typename RandomAccessIterator, typename T, typename Counter>
+void tim_sort_merge(RandomAccessIterator a, RandomAccessIterator b, RandomAccessIterator b_end,
+                    std::vector<T> &tmp, int &min_gallop, Counter &comp)
+{
+    T const &first_right = *b;
+    a = gallop(a, b, [&comp, &first_right](T const &x) { count_comparisons(comp); return !(first_right < x); }, false);
+    if (a == b) return;
+
+    T const &last_left = *(b - 1);
+    b_end = gallop(b, b_end, [&comp, &last_left](T const &x) { count_comparisons(comp); return x < last_left; }, true);
+
+    if (b - a <= b_end - b) tim_sort_merge_lo(a, b, b_end, tmp, min_gallop, comp);
+    else tim_sort_merge_hi(a, b, b_end, tmp, min_gallop, comp);
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order. 
+ * The order of equal elements is preserved.
+ * The type of dereferenced RandomAccessIterator must be comparable with the
+ * < operator. 
+ * 
+ * Natural merge sort: the input is split into ascending and strictly
+ * descending runs, runs shorter than tim_sort_min_run are extended by binary
+ * insertion sort, and runs are merged on a stack whose lengths are kept
+ * decreasing faster than the Fibonacci numbers, which keeps merges balanced.
+ * Sorted inputs take n - 1 comparisons.
+ * 
+ * @param begin iterator pointing to the first element in the range to be
+ *              sorted, such as the iterator returned by std::vector::begin.
+ * @param end   iterator referring to the past-the-end element in the range to
+ *              be sorted, such as the iterator returned by std::vector::end.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void tim_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+    const std::ptrdiff_t size = end - begin;
+    if (size < 2) return;
+
+    if (size < TIM_SORT_MIN_MERGE)
+    {
+        auto run = count_run_and_make_ascending(begin, end, comp);
+        binary_insertion_sort(begin, begin + run, end, comp);
+        return;
+    }
+
+    std::vector<value_type> tmp;
+    tmp.reserve(size / 2);
+    int min_gallop = TIM_SORT_MIN_GALLOP;
+
+    // Each run is stored as its offset from begin and its length
+    std::vector<std::ptrdiff_t> run_base, run_len;
+    auto merge_at = [&](std::size_t i) {
+        auto a = begin + run_base[i];
+        auto b = a + run_len[i];
+        tim_sort_merge(a, b, b + run_len[i + 1], tmp, min_gallop, comp);
+        run_len[i] += run_len[i + 1];
+        run_base.erase(run_base.begin() + (i + 1));
+        run_len.erase(run_len.begin() + (i + 1));
+    };
+
+    const std::ptrdiff_t min_run = tim_sort_min_run(size);
+    auto lo = begin;
+    while (lo < end)
+    {
+        auto run = count_run_and_make_ascending(lo, end, comp);
+        if (run < min_run)
+        {
+            auto forced = std::min(min_run, end - lo);
+            binary_insertion_sort(lo, lo + run, lo + forced, comp);
+            run = forced;
+        }
+        run_base.push_back(lo - begin);
+        run_len.push_back(run);
+        lo += run;
+
+        // Restore len[i - 2] > len[i - 1] + len[i] and len[i - 1] > len[i]
+        // for the top of the stack, also checking one level deeper
+        while (run_len.size() > 1)
+        {
+            std::size_t n = run_len.size() - 2;
+            if ((n > 0 && run_len[n - 1] <= run_len[n] + run_len[n + 1])
+                || (n > 1 && run_len[n - 2] <= run_len[n - 1] + run_len[n]))
+            {
+                if (run_len[n - 1] < run_len[n + 1]) n--;
+            }
+            else if (run_len[n] > run_len[n + 1]) break;
+            merge_at(n);
+        }
+    }
+
+    while (run_len.size() > 1)
+    {
+        std::size_t n = run_len.size() - 2;
+        if (n > 0 && run_len[n - 1] < run_len[n + 1]) n--;
+        merge_at(n);
+    }
+}
+
+/**
+ * Ranges at or below this size are left for small_sort by
+ * three_way_quick_sort.
+ */
+constexpr std::ptrdiff_t THREE_WAY_QUICK_SORT_THRESHOLD = 10;
+
+/**
+ * Partitions [begin, end) three ways around the pivot *begin using
+ * Bentley-McIlroy partitioning. Keys equal to the pivot are swapped to the
+ * two ends of the range while the scan runs and moved to the middle at the
+ * end, so afterwards [begin, lt) < pivot, [lt, gt) == pivot and
+ * [gt, end) > pivot.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void three_way_partition(RandomAccessIterator begin, RandomAccessIterator end,
+                         RandomAccessIterator &lt, RandomAccessIterator &gt, Counter &comp)
+{
+    auto lo = begin, hi = end - 1;
+    auto i = lo, j = end;
+    auto p = lo, q = end;
+    auto pivot = *lo;
+
+    while (true)
+    {
+        while (count_comparisons(comp), *++i < pivot)
+            if (i == hi) break;
+        while (count_comparisons(comp), pivot < *--j)
+            if (j == lo) break;
+
+        // The pointers met on a key equal to the pivot
+        if (i == j && (count_comparisons(comp), !(*i < pivot)))
+            exch(++p, i, comp);
+        if (i >= j) break;
+
+        // After the swap *i <= pivot <= *j, one comparison tells equality
+        exch(i, j, comp);
+        count_comparisons(comp, 2);
+        if (!(*i < pivot)) exch(++p, i, comp);
+        if (!(pivot < *j)) exch(--q, j, comp);
+    }
+
+    // Swap the equal keys from both ends into the middle
+    i = j + 1;
+    for (auto k = lo; k <= p; ++k) exch(k, j--, comp);
+    for (auto k = hi; k >= q; --k) exch(k, i++, comp);
+
+    lt = j + 1;
+    gt = i;
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order. 
+ * The order of equal elements is not guaranteed to be preserved.
+ * Iterators must meet the requirements of ValueSwappable. The type of
+ * dereferenced RandomAccessIterator must be comparable with the < operator. 
+ * 
+ * Quick sort with a median-of-three pivot and three-way partitioning: keys
+ * equal to the pivot are gathered in the middle and never recursed into, so
+ * inputs with a constant number of distinct keys sort in linear time.
+ * 
+ * @param begin iterator pointing to the first element in the range to be
+ *              sorted, such as the iterator returned by std::vector::begin.
+ * @param end   iterator referring to the past-the-end element in the range to
+ *              be sorted, such as the iterator returned by std::vector::end.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void three_way_quick_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    while (end - begin > THREE_WAY_QUICK_SORT_THRESHOLD)
+    {
+        sort3(begin + (end - begin) / 2, begin, end - 1, comp);
+
+        RandomAccessIterator lt, gt;
+        three_way_partition(begin, end, lt, gt, comp);
+
+        // Recurse into the smaller side and loop on the larger one
+        if (lt - begin < end - gt)
+        {
+            three_way_quick_sort(begin, lt, comp);
+            begin = gt;
+        }
+        else
+        {
+            three_way_quick_sort(gt, end, comp);
+            end = lt;
+        }
+    }
+    small_sort(begin, end, comp);
+}
+
+/**
+ * Ranges below this size are left for small_sort by
+ * dual_pivot_quick_sort.
+ */
+constexpr std::ptrdiff_t DUAL_PIVOT_QUICK_SORT_THRESHOLD = 27;
+
+/**
+ * Sorts [begin, end) with Yaroslavskiy's dual-pivot partitioning. The two
+ * pivots are the second and fourth of five evenly spaced samples around the
+ * middle of the range. Afterwards the range holds, in order, keys < p1, p1,
+ * keys in [p1, p2], p2 and keys > p2, and the three parts are sorted
+ * recursively. When the samples give p1 == p2 the range has many copies of
+ * one key and is partitioned three ways around it instead.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void dual_pivot_quick_sort_range(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    const std::ptrdiff_t size = end - begin;
+    if (size < DUAL_PIVOT_QUICK_SORT_THRESHOLD)
+    {
+        small_sort(begin, end, comp);
+        return;
+    }
+
+    // Five samples spaced about a seventh of the range apart
+    const std::ptrdiff_t seventh = (size >> 3) + (size >> 6) + 1;
+    auto e3 = begin + size / 2;
+    auto e2 = e3 - seventh, e1 = e2 - seventh;
+    auto e4 = e3 + seventh, e5 = e4 + seventh;
+    RandomAccessIterator samples[5] = {e1, e2, e3, e4, e5};
+    for (int i = 1; i < 5; ++i)
+        for (int j = i; j > 0 && (count_comparisons(comp), *samples[j] < *samples[j - 1]); --j)
+            exch(samples[j], samples[j - 1], comp);
+
+    count_comparisons(comp);
+    if (*e2 < *e4)
+    {
+        // Park the pivots at the ends so they act as sentinels for the scans
+        auto p1 = *e2, p2 = *e4;
+        exch(e2, begin, comp);
+        exch(e4, end - 1, comp);
+
+        auto less = begin + 1;
+        auto great = end - 2;
+        while (count_comparisons(comp), *less < p1) ++less;
+        while (count_comparisons(comp), p2 < *great) --great;
+
+        // [begin + 1, less) < p1, [less, k) in [p1, p2], (great, end - 1) > p2
+        for (auto k = less; k <= great; ++k)
+        {
+            auto ak = *k;
+            count_comparisons(comp);
+            if (ak < p1)
+            {
+                *k = *less;
+                *less = ak;
+                ++less;
+                count_moves(comp, 3);
+            }
+            else if (count_comparisons(comp), p2 < ak)
+            {
+                bool crossed = false;
+                while (count_comparisons(comp), p2 < *great)
+                {
+                    if (great == k)
+                    {
+                        crossed = true;
+                        break;
+                    }
+                    --great;
+                }
+                if (crossed)
+                {
+                    --great;
+                    break;
+                }
+
+                count_comparisons(comp);
+                if (*great < p1)
+                {
+                    *k = *less;
+                    *less = *great;
+                    ++less;
+                    count_moves(comp);
+                }
+                else *k = *great;
+                *great = ak;
+                --great;
+                count_moves(comp, 3);
+            }
+        }
+
+        // Move the pivots into their final positions
+        *begin = *(less - 1);
+        *(less - 1) = p1;
+        *(end - 1) = *(great + 1);
+        *(great + 1) = p2;
+        count_moves(comp, 6);
+
+        dual_pivot_quick_sort_range(begin, less - 1, comp);
+        dual_pivot_quick_sort_range(great + 2, end, comp);
+
+        // A large middle part usually means many keys equal to a pivot; move
+        // those out first, the neighbouring pivots stop both scans
+        if (less < e1 && e5 < great)
+        {
+            while (count_comparisons(comp), !(p1 < *less)) ++less;
+            while (count_comparisons(comp), !(*great < p2)) --great;
+
+            for (auto k = less; k <= great; ++k)
+            {
+                auto ak = *k;
+                count_comparisons(comp);
+                if (!(p1 < ak))
+                {
+                    *k = *less;
+                    *less = ak;
+                    ++less;
+                    count_moves(comp, 3);
+                }
+                else if (count_comparisons(comp), !(ak < p2))
+                {
+                    bool crossed = false;
+                    while (count_comparisons(comp), !(*great < p2))
+                    {
+                        if (great == k)
+                        {
+                            crossed = true;
+                            break;
+                        }
+                        --great;
+                    }
+                    if (crossed)
+                    {
+                        --great;
+                        break;
+                    }
+
+                    count_comparisons(comp);
+                    if (!(p1 < *great))
+                    {
+                        *k = *less;
+                        *less = *great;
+                        ++less;
+                        count_moves(comp);
+                    }
+                    else *k = *great;
+                    *great = ak;
+                    --great;
+                    count_moves(comp, 3);
+                }
+            }
+        }
+
+        dual_pivot_quick_sort_range(less, great + 1, comp);
+    }
+    else
+    {
+        // p1 == p2: Dijkstra three-way partition around the median sample
+        auto pivot = *e3;
+        auto lt = begin, i = begin, gt = end;
+        while (i < gt)
+        {
+            count_comparisons(comp);
+            if (*i < pivot) exch(lt++, i++, comp);
+            else if (count_comparisons(comp), pivot < *i) exch(i, --gt, comp);
+            else ++i;
+        }
+
+        dual_pivot_quick_sort_range(begin, lt, comp);
+        dual_pivot_quick_sort_range(gt, end, comp);
+    }
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order. 
+ * The order of equal elements is not guaranteed to be preserved.
+ * Iterators must meet the requirements of ValueSwappable. The type of
+ * dereferenced RandomAccessIterator must be comparable with the < operator. 
+ * 
+ * Dual-pivot quick sort (Yaroslavskiy) with pivots chosen from a five
+ * element sample and a small_sort cutoff. Splitting into three parts
+ * per pass scans less memory than single-pivot partitioning.
+ * 
+ * @param begin iterator pointing to the first element in the range to be
+ *              sorted, such as the iterator returned by std::vector::begin.
+ * @param end   iterator referring to the past-the-end element in the range to
+ *              be sorted, such as the iterator returned by std::vector::end.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void dual_pivot_quick_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    dual_pivot_quick_sort_range(begin, end, comp);
+}
+
+/**
+ * Tuning of the samplesorts. Ranges at or below the threshold are sorted by
+ * block_quick_sort alone. Larger ranges are split into about
+ * SAMPLE_SORT_BUCKETS_PER_THREAD buckets per thread, at most
+ * SAMPLE_SORT_MAX_BUCKETS, so that buckets outnumber threads enough to
+ * balance the load, and no bucket is expected to be smaller than
+ * SAMPLE_SORT_MIN_BUCKET_SIZE.
+ */
+constexpr std::size_t PARALLEL_SAMPLE_SORT_THRESHOLD = 1 << 14;
+constexpr std::size_t SAMPLE_SORT_BUCKETS_PER_THREAD = 64;
+constexpr std::size_t SAMPLE_SORT_MAX_BUCKETS = 4096;
+constexpr std::size_t SAMPLE_SORT_MIN_BUCKET_SIZE = 256;
+
+/**
+ * Returns the number of buckets, a power of two, to split size elements into
+ * for num_threads threads.
+ */
+inline std::size_t sample_sort_buckets(std::size_t size, unsigned num_threads)
+{
+    const std::size_t wanted = std::min<std::size_t>(std::max(num_threads, 1u) * SAMPLE_SORT_BUCKETS_PER_THREAD,
+                                                     std::min(SAMPLE_SORT_MAX_BUCKETS, size / SAMPLE_SORT_MIN_BUCKET_SIZE));
+    std::size_t buckets = 2;
+    while (buckets < wanted) buckets *= 2;
+    return buckets;
+}
+
+/**
+ * Assigns elements to the buckets of a samplesort. The splitters are drawn
+ * from a random sample oversampled by a factor of about log2(n) / 5, and
+ * stored as an implicit search tree in breadth-first order, so classifying
+ * an element descends log2(k) levels with one comparison each and no
+ * branch: the comparison result is added to the index of the next node.
+ *
+ * Splitters repeated in the sample mean a value makes up a large share of
+ * the input. The classifier then drops the duplicates and adds an equality
+ * bucket after each splitter, holding the elements equal to it, which need
+ * no sorting. Otherwise a skewed input would pile into one bucket.
+ */
+template <typename T>
+class SampleSortClassifier {
+public:
+    /**
+     * Chooses up to max_buckets - 1 splitters, max_buckets being a power of
+     * two, from a sample of [begin, end). Sampling is seeded with the size of
+     * the range, so the same input always gets the same buckets.
+     */
+    template <typename RandomAccessIterator, typename Counter>
+    SampleSortClassifier(RandomAccessIterator begin, RandomAccessIterator end, std::size_t max_buckets, Counter &comp)
+    {
+        const std::size_t size = end - begin;
+        const std::size_t oversampling = std::max(1, floor_log2(size) / 5);
+
+        Xoshiro256 rng(size);
+        std::vector<T> sample;
+        sample.reserve(oversampling * max_buckets - 1);
+        for (std::size_t i = 0; i + 1 < oversampling * max_buckets; ++i)
+        {
+            sample.push_back(begin[uniform_below(rng, size)]);
+        }
+        count_moves(comp, sample.size());
+        block_quick_sort(sample.begin(), sample.end(), comp);
+
+        equality = false;
+        for (std::size_t i = oversampling - 1; i < sample.size(); i += oversampling)
+        {
+            if (!splitters.empty())
+            {
+                count_comparisons(comp);
+                if (!(splitters.back() < sample[i]))
+                {
+                    equality = true;
+                    continue;
+                }
+            }
+            splitters.push_back(sample[i]);
+        }
+
+        // Pad with the largest splitter to a full tree of 2^levels - 1 nodes,
+        // plus one so that splitters[b] is defined for every bucket b
+        levels = 1;
+        while ((std::size_t(1) << levels) <= splitters.size()) ++levels;
+        buckets = std::size_t(1) << levels;
+        splitters.resize(buckets, splitters.back());
+
+        tree.resize(buckets);
+        build_tree(1, 0, buckets);
+    }
+
+    /**
+     * Returns the number of buckets, counting the equality buckets.
+     */
+    std::size_t num_buckets() const
+    {
+        return equality ? 2 * buckets : buckets;
+    }
+
+    /**
+     * Returns whether every element of bucket b is equal, so the bucket is
+     * sorted already.
+     */
+    bool equality_bucket(std::size_t b) const
+    {
+        return equality && b % 2 == 1;
+    }
+
+    /**
+     * Returns the comparisons classifying one element takes.
+     */
+    std::size_t comparisons_per_element() const
+    {
+        return levels + (equality ? 1 : 0);
+    }
+
+    /**
+     * Returns the bucket of value. Elements of bucket b are no larger than
+     * the elements of bucket b + 1.
+     */
+    std::size_t operator()(T const &value) const
+    {
+        std::size_t i = 1;
+        for (int level = 0; level < levels; ++level)
+        {
+            i = 2 * i + (tree[i] < value);
+        }
+        std::size_t b = i - buckets;
+        if (equality)
+        {
+            // Not below splitter b, which bounds bucket b from above, means
+            // equal. The last bucket has no splitter
+            b = 2 * b + (!(value < splitters[b]) & (b + 1 < buckets));
+        }
+        return b;
+    }
+
+private:
+    /**
+     * Stores the median of splitters [first, last) at node, and the halves
+     * below it at its children 2 * node and 2 * node + 1.
+     */
+    void build_tree(std::size_t node, std::size_t first, std::size_t last)
+    {
+        if (node >= buckets) return;
+        const std::size_t mid = first + (last - first) / 2;
+        tree[node] = splitters[mid - 1];
+        build_tree(2 * node, first, mid);
+        build_tree(2 * node + 1, mid, last);
+    }
+
+    std::vector<T> splitters;
+    std::vector<T> tree;
+    std::size_t buckets;
+    int levels;
+    bool equality;
+};
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order using
+ * num_threads threads, by samplesort. A classifier chooses splitters for
+ * about SAMPLE_SORT_BUCKETS_PER_THREAD buckets per thread. Each thread then
+ * classifies a stripe of the range, remembering the bucket of every element
+ * and counting its buckets, the counts give every stripe its place in every
+ * bucket, and each thread moves its stripe into a buffer in bucket order.
+ * Finally every bucket is a task that sorts the bucket with
+ * block_quick_sort and moves it back. Equality buckets are only moved back.
+ *
+ * The splitters depend on the number of threads, and so do the counts.
+ * 
+ * @param begin iterator pointing to the first element in the range to be
+ *              sorted, such as the iterator returned by std::vector::begin.
+ * @param end   iterator referring to the past-the-end element in the range to
+ *              be sorted, such as the iterator returned by std::vector::end.
+ * @param num_threads number of threads to sort with, including the caller.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void parallel_sample_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp, unsigned num_threads)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+    const std::size_t size = end - begin;
+    if (size <= PARALLEL_SAMPLE_SORT_THRESHOLD)
+    {
+        block_quick_sort(begin, end, comp);
+        return;
+    }
+    if (num_threads < 1) num_threads = 1;
+
+    const SampleSortClassifier<value_type> classify(begin, end, sample_sort_buckets(size, num_threads), comp);
+    const std::size_t num_buckets = classify.num_buckets();
+    static_assert(2 * SAMPLE_SORT_MAX_BUCKETS <= 1 << 16, "bucket numbers must fit the oracle");
+
+    // The bucket of every element, and counts[s * num_buckets + b] the
+    // elements of stripe s in bucket b
+    const std::size_t stripes = num_threads;
+    std::vector<std::uint16_t> oracle(size);
+    std::vector<std::size_t> counts(stripes * num_buckets);
+    auto stripe_begin = [size, stripes](std::size_t s) { return size * s / stripes; };
+
+    AtomicOpCounter total;
+    WorkStealingPool &pool = thread_pool_for(num_threads);
+
+    pool.run_all(stripes, [&](std::size_t s) {
+        std::size_t *count = &counts[s * num_buckets];
+        const std::size_t first = stripe_begin(s), last = stripe_begin(s + 1);
+        for (std::size_t i = first; i < last; ++i)
+        {
+            const std::size_t b = classify(begin[i]);
+            oracle[i] = static_cast<std::uint16_t>(b);
+            ++count[b];
+        }
+        Counter local = Counter();
+        count_comparisons(local, (last - first) * classify.comparisons_per_element());
+        add_counts(total, local);
+    });
+
+    // Turn the counts into offsets: bucket b of stripe s follows every
+    // smaller bucket and bucket b of every earlier stripe
+    std::vector<std::size_t> bucket_begin(num_buckets + 1);
+    std::size_t offset = 0;
+    for (std::size_t b = 0; b < num_buckets; ++b)
+    {
+        bucket_begin[b] = offset;
+        for (std::size_t s = 0; s < stripes; ++s)
+        {
+            const std::size_t count = counts[s * num_buckets + b];
+            counts[s * num_buckets + b] = offset;
+            offset += count;
+        }
+    }
+    bucket_begin[num_buckets] = size;
+
+    std::vector<value_type> buffer(size);
+    pool.run_all(stripes, [&](std::size_t s) {
+        std::size_t *next = &counts[s * num_buckets];
+        const std::size_t first = stripe_begin(s), last = stripe_begin(s + 1);
+        for (std::size_t i = first; i < last; ++i)
+        {
+            buffer[next[oracle[i]]++] = std::move(begin[i]);
+        }
+        Counter local = Counter();
+        count_moves(local, last - first);
+        add_counts(total, local);
+    });
+
+    pool.run_all(num_buckets, [&](std::size_t b) {
+        auto first = buffer.begin() + bucket_begin[b], last = buffer.begin() + bucket_begin[b + 1];
+        Counter local = Counter();
+        if (!classify.equality_bucket(b)) block_quick_sort(first, last, local);
+        std::move(first, last, begin + bucket_begin[b]);
+        count_moves(local, last - first);
+        add_counts(total, local);
+    });
+    add_counts(comp, total);
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order using every
+ * hardware thread. See parallel_sample_sort above.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void parallel_sample_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    parallel_sample_sort(begin, end, comp, default_thread_count());
+}
+
+/**
+ * Tuning of in_place_sample_sort. Elements move between the buffers of the
+ * threads and the range in blocks of IN_PLACE_SAMPLE_SORT_BLOCK_BYTES, and
+ * a step splits its range into at most IN_PLACE_SAMPLE_SORT_MAX_BUCKETS
+ * buckets, so a thread buffers at most 2 * 256 blocks of 2 KiB, 1 MiB,
+ * whatever the size of the input.
+ */
+constexpr std::size_t IN_PLACE_SAMPLE_SORT_BLOCK_BYTES = 2048;
+constexpr std::size_t IN_PLACE_SAMPLE_SORT_MAX_BUCKETS = 256;
+
+/**
+ * Returns the number of buckets, a power of two, that in_place_sample_sort
+ * splits size elements into with blocks of block elements. Buckets are
+ * kept several blocks long on average, since every bucket of every thread
+ * ends with a partial block that has to be cleaned up.
+ */
+inline std::size_t in_place_sample_sort_buckets(std::size_t size, std::size_t block)
+{
+    const std::size_t wanted = std::min(IN_PLACE_SAMPLE_SORT_MAX_BUCKETS, size / (8 * block));
+    std::size_t buckets = 2;
+    while (buckets < wanted) buckets *= 2;
+    return buckets;
+}
+
+/**
+ * The buffers of one thread of in_place_sample_sort: a block for every
+ * bucket and two blocks to swap blocks through.
+ */
+template <typename T>
+struct InPlaceSampleSortBuffers
+{
+    std::vector<T> blocks;
+    std::vector<std::size_t> fill;
+    std::vector<T> swap;
+
+    /**
+     * Empties every bucket, growing the buffers as needed.
+     */
+    void prepare(std::size_t num_buckets, std::size_t block)
+    {
+        if (blocks.size() < num_buckets * block) blocks.resize(num_buckets * block);
+        if (swap.size() < 2 * block) swap.resize(2 * block);
+        fill.assign(num_buckets, 0);
+    }
+};
+
+/**
+ * The write and read pointers of the blocks of one bucket, packed into one
+ * atomic word so both are read together. Blocks before write are in their
+ * bucket already, blocks from write up to read are waiting to be moved, and
+ * blocks from read on are empty. Block numbers must fit 32 bits.
+ */
+class SampleSortBlockPointers {
+public:
+    SampleSortBlockPointers(): pointers(0), reading(0) {}
+
+    void set(std::uint64_t write, std::uint64_t read)
+    {
+        pointers = write << 32 | read;
+    }
+
+    std::size_t write() const
+    {
+        return static_cast<std::size_t>(pointers.load() >> 32);
+    }
+
+    /**
+     * Claims the last block waiting to be moved. Returns false when there
+     * is none. The caller calls done_reading once the block is copied out.
+     */
+    bool pop_read(std::size_t &block)
+    {
+        // Announced before the claim, so a writer that sees the slot empty
+        // also sees the read in progress
+        reading++;
+        std::uint64_t current = pointers.load();
+        do
+        {
+            if ((current >> 32) >= (current & 0xffffffff))
+            {
+                reading--;
+                return false;
+            }
+        } while (!pointers.compare_exchange_weak(current, current - 1));
+        block = static_cast<std::size_t>((current & 0xffffffff) - 1);
+        return true;
+    }
+
+    void done_reading()
+    {
+        reading--;
+    }
+
+    /**
+     * Claims the next slot of the bucket. occupied tells whether the slot
+     * holds a block waiting to be moved, which the caller has to take out
+     * before writing.
+     */
+    std::size_t push_write(bool &occupied)
+    {
+        const std::uint64_t current = pointers.fetch_add(std::uint64_t(1) << 32);
+        occupied = (current >> 32) < (current & 0xffffffff);
+        return static_cast<std::size_t>(current >> 32);
+    }
+
+    /**
+     * Waits until no block of the bucket is being copied out, so an empty
+     * slot can be written.
+     */
+    void wait_for_readers() const
+    {
+        while (reading.load() != 0) std::this_thread::yield();
+    }
+
+private:
+    std::atomic<std::uint64_t> pointers;
+    std::atomic<std::size_t> reading;
+};
+
+/**
+ * Runs task(i) for every i in [0, count), on pool if there is one and one
+ * after the other otherwise.
+ */
+template <typename F>
+void run_tasks(WorkStealingPool *pool, std::size_t count, F const &task)
+{
+    if (pool)
+    {
+        pool->run_all(count, task);
+        return;
+    }
+    for (std::size_t i = 0; i < count; ++i) task(i);
+}
+
+/**
+ * Splits [begin, end) into the buckets of classify in place, with one
+ * stripe of the range for each of the stripes buffers, and returns where each
+ * bucket begins, followed by end - begin. The stripes run on pool when it
+ * is given. It takes four phases, each of them parallel:
+ *
+ * 1. Each stripe classifies its elements into its buffers. A full buffer is
+ *    written back as a block to the start of the stripe, where the elements
+ *    were read already.
+ * 2. The range is cut into block-aligned regions, one per bucket and large
+ *    enough for its full blocks. The full blocks of each region are moved
+ *    to its front. Only blocks at stripe ends move, at most one per bucket
+ *    and stripe.
+ * 3. Every stripe takes blocks from the regions and writes each to the next
+ *    slot of the region of its bucket, taking out the block waiting there
+ *    first if there is one, until every block is in its region.
+ * 4. The parts of blocks that stick out into the next bucket are saved, and
+ *    then the gaps at both ends of every bucket are filled with them and
+ *    the partial blocks left in the buffers.
+ *
+ * A block written past end, which can only be the last, goes to an
+ * overflow block.
+ */
+template <typename RandomAccessIterator, typename T, typename Counter, typename Total>
+std::vector<std::size_t> in_place_sample_partition(RandomAccessIterator begin, RandomAccessIterator end,
+                                                   SampleSortClassifier<T> const &classify, std::size_t block,
+                                                   InPlaceSampleSortBuffers<T> *buffers, std::size_t stripes,
+                                                   WorkStealingPool *pool, Total &total)
+{
+    const std::size_t size = end - begin;
+    const std::size_t num_buckets = classify.num_buckets();
+    const std::size_t full_blocks = size / block;
+    const std::size_t num_blocks = (size + block - 1) / block;
+
+    // Stripes start at block boundaries, the last one takes the partial
+    // block at the end
+    std::vector<std::size_t> stripe_begin(stripes + 1), written(stripes);
+    for (std::size_t s = 0; s < stripes; ++s) stripe_begin[s] = full_blocks * s / stripes * block;
+    stripe_begin[stripes] = size;
+
+    // Phase 1: local classification
+    std::vector<std::size_t> counts(stripes * num_buckets);
+    run_tasks(pool, stripes, [&](std::size_t s) {
+        InPlaceSampleSortBuffers<T> &buffer = buffers[s];
+        buffer.prepare(num_buckets, block);
+        std::size_t *count = &counts[s * num_buckets];
+        Counter local = Counter();
+
+        std::size_t out = stripe_begin[s];
+        for (std::size_t i = stripe_begin[s]; i < stripe_begin[s + 1]; ++i)
+        {
+            const std::size_t b = classify(begin[i]);
+            T *bucket_block = &buffer.blocks[b * block];
+            if (buffer.fill[b] == block)
+            {
+                std::move(bucket_block, bucket_block + block, begin + out);
+                count_moves(local, block);
+                out += block;
+                buffer.fill[b] = 0;
+            }
+            bucket_block[buffer.fill[b]++] = std::move(begin[i]);
+            ++count[b];
+        }
+        written[s] = out;
+        count_comparisons(local, (stripe_begin[s + 1] - stripe_begin[s]) * classify.comparisons_per_element());
+        count_moves(local, stripe_begin[s + 1] - stripe_begin[s]);
+        add_counts(total, local);
+    });
+
+    std::vector<std::size_t> bucket_begin(num_buckets + 1), region(num_buckets + 1);
+    std::size_t offset = 0;
+    for (std::size_t b = 0; b < num_buckets; ++b)
+    {
+        bucket_begin[b] = offset;
+        region[b] = (offset + block - 1) / block;
+        for (std::size_t s = 0; s < stripes; ++s) offset += counts[s * num_buckets + b];
+    }
+    bucket_begin[num_buckets] = size;
+    region[num_buckets] = num_blocks;
+
+    // Phase 2: move the full blocks of every region to its front
+    auto is_full = [&](std::size_t j) {
+        const std::size_t s = std::upper_bound(stripe_begin.begin(), stripe_begin.end() - 1, j * block) - stripe_begin.begin() - 1;
+        return j * block < written[s];
+    };
+    std::vector<SampleSortBlockPointers> pointers(num_buckets);
+    run_tasks(pool, num_buckets, [&](std::size_t b) {
+        std::size_t low = region[b], high = region[b + 1];
+        Counter local = Counter();
+        for (;;)
+        {
+            while (low < high && is_full(low)) ++low;
+            while (low < high && !is_full(high - 1)) --high;
+            if (low >= high) break;
+            --high;
+            std::move(begin + high * block, begin + (high + 1) * block, begin + low * block);
+            count_moves(local, block);
+            ++low;
+        }
+        pointers[b].set(region[b], low);
+        add_counts(total, local);
+    });
+
+    // Phase 3: permute the blocks
+    std::vector<T> overflow(size % block == 0 ? 0 : block);
+    run_tasks(pool, stripes, [&](std::size_t s) {
+        T *current = &buffers[s].swap[0];
+        T *other = current + block;
+        Counter local = Counter();
+
+        for (std::size_t n = 0, b = s * num_buckets / stripes; n < num_buckets; ++n, b = (b + 1) % num_buckets)
+        {
+            std::size_t read;
+            while (pointers[b].pop_read(read))
+            {
+                std::move(begin + read * block, begin + (read + 1) * block, current);
+                pointers[b].done_reading();
+                count_moves(local, block);
+
+                for (;;)
+                {
+                    const std::size_t dest = classify(current[0]);
+                    count_comparisons(local, classify.comparisons_per_element());
+                    bool occupied;
+                    const std::size_t slot = pointers[dest].push_write(occupied);
+                    count_moves(local, block);
+                    if (occupied)
+                    {
+                        std::move(begin + slot * block, begin + (slot + 1) * block, other);
+                        std::move(current, current + block, begin + slot * block);
+                        std::swap(current, other);
+                        count_moves(local, block);
+                        continue;
+                    }
+                    if (slot >= full_blocks)
+                    {
+                        std::move(current, current + block, overflow.begin());
+                        break;
+                    }
+                    pointers[dest].wait_for_readers();
+                    std::move(current, current + block, begin + slot * block);
+                    break;
+                }
+            }
+        }
+        add_counts(total, local);
+    });
+
+    // The part of the overflow block that fits belongs to the last bucket
+    std::vector<std::size_t> written_end(num_buckets);
+    for (std::size_t b = 0; b < num_buckets; ++b) written_end[b] = pointers[b].write() * block;
+    if (written_end[num_buckets - 1] > size)
+    {
+        std::move(overflow.begin(), overflow.begin() + (size - full_blocks * block), begin + full_blocks * block);
+    }
+    auto at = [&](std::size_t i) -> T & {
+        return i < size ? begin[i] : overflow[i - full_blocks * block];
+    };
+
+    // Phase 4: save what sticks out of every bucket, then fill the gaps
+    std::vector<std::size_t> spill_begin(num_buckets + 1);
+    for (std::size_t b = 0; b < num_buckets; ++b)
+    {
+        const std::size_t first = std::max(bucket_begin[b + 1], region[b] * block);
+        spill_begin[b + 1] = spill_begin[b] + (written_end[b] > first ? written_end[b] - first : 0);
+    }
+    std::vector<T> spill(spill_begin[num_buckets]);
+    run_tasks(pool, num_buckets, [&](std::size_t b) {
+        const std::size_t first = written_end[b] - (spill_begin[b + 1] - spill_begin[b]);
+        for (std::size_t i = spill_begin[b]; i < spill_begin[b + 1]; ++i)
+        {
+            spill[i] = std::move(at(first + i - spill_begin[b]));
+        }
+        Counter local = Counter();
+        count_moves(local, spill_begin[b + 1] - spill_begin[b]);
+        add_counts(total, local);
+    });
+
+    run_tasks(pool, num_buckets, [&](std::size_t b) {
+        const std::size_t head_end = std::min(region[b] * block, bucket_begin[b + 1]);
+        const std::size_t tail_begin = std::max(written_end[b], head_end);
+        std::size_t gap = bucket_begin[b];
+        Counter local = Counter();
+        auto place = [&](T &value) {
+            if (gap == head_end) gap = tail_begin;
+            begin[gap++] = std::move(value);
+        };
+
+        for (std::size_t i = spill_begin[b]; i < spill_begin[b + 1]; ++i) place(spill[i]);
+        for (std::size_t s = 0; s < stripes; ++s)
+        {
+            T *bucket_block = &buffers[s].blocks[b * block];
+            for (std::size_t i = 0; i < buffers[s].fill[b]; ++i) place(bucket_block[i]);
+        }
+        count_moves(local, gap - bucket_begin[b]);
+        add_counts(total, local);
+    });
+
+    return bucket_begin;
+}
+
+/**
+ * Sorts [begin, end) by in-place samplesort on the calling thread alone,
+ * recursing into every bucket that needs sorting. Ranges at or below
+ * PARALLEL_SAMPLE_SORT_THRESHOLD, and buckets the step failed to split,
+ * are sorted by block_quick_sort.
+ */
+template <typename RandomAccessIterator, typename T, typename Counter>
+void in_place_sample_sort_range(RandomAccessIterator begin, RandomAccessIterator end,
+                                InPlaceSampleSortBuffers<T> &buffers, std::size_t block, Counter &comp)
+{
+    const std::size_t size = end - begin;
+    if (size <= PARALLEL_SAMPLE_SORT_THRESHOLD)
+    {
+        block_quick_sort(begin, end, comp);
+        return;
+    }
+
+    const SampleSortClassifier<T> classify(begin, end, in_place_sample_sort_buckets(size, block), comp);
+    const std::vector<std::size_t> bucket_begin =
+        in_place_sample_partition<RandomAccessIterator, T, Counter>(begin, end, classify, block, &buffers, 1, nullptr, comp);
+
+    for (std::size_t b = 0; b < classify.num_buckets(); ++b)
+    {
+        if (classify.equality_bucket(b)) continue;
+        auto first = begin + bucket_begin[b], last = begin + bucket_begin[b + 1];
+        if (static_cast<std::size_t>(last - first) == size) block_quick_sort(first, last, comp);
+        else in_place_sample_sort_range(first, last, buffers, block, comp);
+    }
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order using
+ * num_threads threads, by an in-place samplesort after IPS4o by Axtmann,
+ * Witt, Ferizovic and Sanders. Splitters and classification are those of
+ * parallel_sample_sort, but instead of scattering into a buffer as large
+ * as the input, in_place_sample_partition moves the elements in blocks
+ * through small per-thread buffers and permutes the blocks in place. The
+ * buckets of the first step are then tasks on the pool, each sorted by
+ * recursive in-place samplesort on one thread.
+ *
+ * The work is O(n log n) and the extra memory O(k * b * p) for k buckets
+ * of blocks of b elements and p threads, independent of n. The splitters
+ * depend on the number of threads, and so do the counts.
+ * 
+ * @param begin iterator pointing to the first element in the range to be
+ *              sorted, such as the iterator returned by std::vector::begin.
+ * @param end   iterator referring to the past-the-end element in the range to
+ *              be sorted, such as the iterator returned by std::vector::end.
+ * @param num_threads number of threads to sort with, including the caller.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void in_place_sample_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp, unsigned num_threads)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+    const std::size_t size = end - begin;
+    if (size <= PARALLEL_SAMPLE_SORT_THRESHOLD)
+    {
+        block_quick_sort(begin, end, comp);
+        return;
+    }
+    if (num_threads < 1) num_threads = 1;
+
+    const std::size_t block = std::max<std::size_t>(1, IN_PLACE_SAMPLE_SORT_BLOCK_BYTES / sizeof(value_type));
+    const SampleSortClassifier<value_type> classify(begin, end, in_place_sample_sort_buckets(size, block), comp);
+
+    AtomicOpCounter total;
+    WorkStealingPool &pool = thread_pool_for(num_threads);
+    std::vector<InPlaceSampleSortBuffers<value_type>> buffers(num_threads);
+    const std::vector<std::size_t> bucket_begin = in_place_sample_partition<RandomAccessIterator, value_type, Counter>(
+        begin, end, classify, block, buffers.data(), num_threads, &pool, total);
+
+    // Every thread sorts its buckets through the buffers it partitioned with
+    pool.run_all(classify.num_buckets(), [&](std::size_t b) {
+        if (classify.equality_bucket(b)) return;
+        Counter local = Counter();
+        in_place_sample_sort_range(begin + bucket_begin[b], begin + bucket_begin[b + 1], buffers[pool.thread_index()], block, local);
+        add_counts(total, local);
+    });
+    add_counts(comp, total);
+}
+
+/**
+ * Sorts the elements in the range [begin, end) in ascending order using every
+ * hardware thread. See in_place_sample_sort above.
+ */ 
+template <typename RandomAccessIterator, typename Counter>
+void in_place_sample_sort(RandomAccessIterator begin, RandomAccessIterator end, Counter &comp)
+{
+    in_place_sample_sort(begin, end, comp, default_thread_count());
+}
+
+/**
+ * Overloads without a counter for production use. They instantiate the
+ * algorithms above with NullCounter, whose counting calls compile to
+ * nothing, so no time is spent on instrumentation.
+ */ 
+template <typename RandomAccessIterator>
+void insertion_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    insertion_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void selection_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    selection_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void bubble_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    bubble_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void merge_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    merge_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator, typename BufferIterator>
+typename std::enable_if<is_dereferenceable<BufferIterator>::value>::type
+merge_sort(RandomAccessIterator begin, RandomAccessIterator end, BufferIterator buffer)
+{
+    NullCounter counter;
+    merge_sort(begin, end, buffer, counter);
+}
+
+template <typename RandomAccessIterator>
+void parallel_merge_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    parallel_merge_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void parallel_sample_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    parallel_sample_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void in_place_sample_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    in_place_sample_sort(begin, end, counter);
+}
+
+/**
+ * Like every overload here these take the range [begin, end), while the
+ * quick sorts above take their last element inclusively.
+ */ 
+template <typename RandomAccessIterator>
+void quick_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    if (begin == end) return;
+    NullCounter counter;
+    quick_sort(begin, end - 1, counter);
+}
+
+template <typename RandomAccessIterator>
+void hoare_quick_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    if (begin == end) return;
+    NullCounter counter;
+    hoare_quick_sort(begin, end - 1, counter);
+}
+
+template <typename RandomAccessIterator>
+void randomized_quick_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    if (begin == end) return;
+    NullCounter counter;
+    randomized_quick_sort(begin, end - 1, counter);
+}
+
+template <typename RandomAccessIterator>
+void heap_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    heap_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void intro_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    intro_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void lsd_radix_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    lsd_radix_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void block_quick_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    block_quick_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void tim_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    tim_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void three_way_quick_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    three_way_quick_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void dual_pivot_quick_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    dual_pivot_quick_sort(begin, end, counter);
+}
+
+template <typename RandomAccessIterator>
+void small_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    NullCounter counter;
+    small_sort(begin, end, counter);
+}
+
+#endif
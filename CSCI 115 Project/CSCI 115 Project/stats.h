@@ -0,0 +1,206 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Summary of the trials of one benchmark cell. Times are in nanoseconds.
+ * trials counts the samples the summary is computed from, outliers the
+ * samples that were rejected before that.
+ */
+struct TimingStats {
+    std::size_t trials;
+    std::size_t outliers;
+    double min;
+    double median;
+    double p90;
+    double p99;
+    double mean;
+    double stddev;
+    double ns_per_element;
+    double elements_per_second;
+
+    TimingStats():
+        trials(0),
+        outliers(0),
+        min(0),
+        median(0),
+        p90(0),
+        p99(0),
+        mean(0),
+        stddev(0),
+        ns_per_element(0),
+        elements_per_second(0) {}
+};
+
+/**
+ * Returns the p-th quantile, 0 <= p <= 1, of the ascending range sorted by
+ * linear interpolation between the two closest ranks.
+ */
+inline double percentile(std::vector<double> const &sorted, double p)
+{
+    if (sorted.empty()) return 0;
+
+    const double rank = p * (sorted.size() - 1);
+    const std::size_t lo = static_cast<std::size_t>(rank);
+    if (lo + 1 >= sorted.size()) return sorted.back();
+    return sorted[lo] + (rank - lo) * (sorted[lo + 1] - sorted[lo]);
+}
+
+inline double sample_mean(std::vector<double> const &samples)
+{
+    if (samples.empty()) return 0;
+
+    double sum = 0;
+    for (double x : samples) sum += x;
+    return sum / samples.size();
+}
+
+/**
+ * Returns the sample standard deviation, with Bessel's correction.
+ */
+inline double sample_stddev(std::vector<double> const &samples)
+{
+    if (samples.size() < 2) return 0;
+
+    const double mean = sample_mean(samples);
+    double sum = 0;
+    for (double x : samples) sum += (x - mean) * (x - mean);
+    return std::sqrt(sum / (samples.size() - 1));
+}
+
+/**
+ * Returns the two-sided 95% critical value of Student's t distribution with
+ * dof degrees of freedom.
+ */
+inline double student_t_95(std::size_t dof)
+{
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+    };
+    if (dof == 0) return INFINITY;
+    if (dof <= 30) return table[dof - 1];
+    if (dof <= 60) return 2.000;
+    if (dof <= 120) return 1.980;
+    return 1.960;
+}
+
+/**
+ * Returns the half-width of the 95% confidence interval of the mean of
+ * samples, relative to the mean. Benchmarks keep adding trials until this
+ * drops below their target.
+ */
+inline double relative_confidence_interval(std::vector<double> const &samples)
+{
+    const double mean = sample_mean(samples);
+    if (samples.size() < 2 || mean <= 0) return INFINITY;
+    return student_t_95(samples.size() - 1) * sample_stddev(samples) / std::sqrt(samples.size()) / mean;
+}
+
+/**
+ * Welch's t-test: returns whether two samples, given by their mean,
+ * standard deviation and size, have different means at the 5% level.
+ * Unlike Student's test it does not assume equal variances, which two
+ * benchmark runs on different builds rarely have.
+ */
+inline bool significantly_different(double mean_a, double stddev_a, std::size_t n_a,
+                                    double mean_b, double stddev_b, std::size_t n_b)
+{
+    if (n_a < 2 || n_b < 2) return false;
+
+    const double var_a = stddev_a * stddev_a / n_a;
+    const double var_b = stddev_b * stddev_b / n_b;
+    if (var_a + var_b <= 0) return mean_a != mean_b;
+
+    const double t = std::abs(mean_a - mean_b) / std::sqrt(var_a + var_b);
+    // Welch-Satterthwaite degrees of freedom
+    const double dof = (var_a + var_b) * (var_a + var_b)
+        / (var_a * var_a / (n_a - 1) + var_b * var_b / (n_b - 1));
+    return t > student_t_95(static_cast<std::size_t>(dof));
+}
+
+/**
+ * Removes the samples outside Tukey's fences, more than 1.5 interquartile
+ * ranges below the first or above the third quartile, and returns how many
+ * were removed. Such samples are usually a trial that was preempted or
+ * page faulted rather than a property of the algorithm.
+ */
+inline std::size_t reject_outliers(std::vector<double> &samples)
+{
+    if (samples.size() < 4) return 0;
+
+    std::vector<double> sorted = samples;
+    std::sort(sorted.begin(), sorted.end());
+    const double q1 = percentile(sorted, 0.25);
+    const double q3 = percentile(sorted, 0.75);
+    const double lo = q1 - 1.5 * (q3 - q1);
+    const double hi = q3 + 1.5 * (q3 - q1);
+
+    const std::size_t size = samples.size();
+    samples.erase(std::remove_if(samples.begin(), samples.end(),
+                                 [lo, hi](double x) { return x < lo || hi < x; }),
+                  samples.end());
+    return size - samples.size();
+}
+
+/**
+ * Summarizes the trial times in nanoseconds of a sort of elements elements.
+ *
+ * @param samples time of every trial in nanoseconds.
+ * @param elements number of elements sorted per trial, for the throughput.
+ * @param discard_outliers whether to drop outliers with reject_outliers first.
+ */
+inline TimingStats summarize(std::vector<double> samples, std::size_t elements, bool discard_outliers)
+{
+    TimingStats stats;
+    if (discard_outliers) stats.outliers = reject_outliers(samples);
+    if (samples.empty()) return stats;
+
+    std::sort(samples.begin(), samples.end());
+    stats.trials = samples.size();
+    stats.min = samples.front();
+    stats.median = percentile(samples, 0.50);
+    stats.p90 = percentile(samples, 0.90);
+    stats.p99 = percentile(samples, 0.99);
+    stats.mean = sample_mean(samples);
+    stats.stddev = sample_stddev(samples);
+
+    if (elements > 0) stats.ns_per_element = stats.median / elements;
+    if (stats.median > 0) stats.elements_per_second = elements * 1e9 / stats.median;
+    return stats;
+}
+
+/**
+ * Fits time = c * size^k to measured points by least squares on their
+ * logarithms and returns the time the fit predicts at next_size, or 0 with
+ * fewer than two usable points. k is kept at 1 or above: no sort is
+ * sublinear, and fixed overheads that dominate small sizes must not make a
+ * large size look cheap.
+ */
+inline double predict_power_law(std::vector<double> const &sizes, std::vector<double> const &times, double next_size)
+{
+    double sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+    std::size_t points = 0;
+    for (std::size_t i = 0; i < sizes.size() && i < times.size(); ++i) {
+        if (sizes[i] <= 0 || times[i] <= 0) continue;
+        const double x = std::log(sizes[i]), y = std::log(times[i]);
+        sum_x += x;
+        sum_y += y;
+        sum_xx += x * x;
+        sum_xy += x * y;
+        ++points;
+    }
+    const double spread = points * sum_xx - sum_x * sum_x;
+    if (points < 2 || spread <= 0 || next_size <= 0) return 0;
+
+    const double k = std::max(1.0, (points * sum_xy - sum_x * sum_y) / spread);
+    const double log_c = (sum_y - k * sum_x) / points;
+    return std::exp(log_c + k * std::log(next_size));
+}
+
+#endif
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+#include "../analysis.h"
+#include <cmath>
+#include <vector>
+
+static ComplexityFit const &best_fit(std::vector<ComplexityFit> const &fits) {
+    std::size_t best = 0;
+    for (std::size_t i = 0; i < fits.size(); ++i)
+        if (fits[i].best) best = i;
+    return fits[best];
+}
+
+// -------------------------------------------------------------
+// Complexity fit test cases
+// -------------------------------------------------------------
+TEST_CASE( "complexity fit" ) {
+
+    std::vector<double> sizes;
+    for (double n = 64; n <= 65536; n *= 2) sizes.push_back(n);
+
+    SECTION( "selects n^2 for quadratic costs" ) {
+        std::vector<double> costs;
+        for (double n : sizes) costs.push_back(0.25 * n * n);
+        std::vector<ComplexityFit> fits = fit_complexity(sizes, costs, 0);
+        REQUIRE(fits.size() == NUM_MODELS);
+        REQUIRE(best_fit(fits).model == N_SQUARED);
+        REQUIRE(best_fit(fits).a == Approx(0.25));
+        REQUIRE(best_fit(fits).r_squared == Approx(1));
+    }
+
+    SECTION( "recovers both terms of n log n plus n" ) {
+        std::vector<double> costs;
+        for (double n : sizes) costs.push_back(3 * n * std::log2(n) + 50 * n);
+        std::vector<ComplexityFit> fits = fit_complexity(sizes, costs, 0);
+        REQUIRE(best_fit(fits).model == N_LOG_N_PLUS_N);
+        REQUIRE(best_fit(fits).a == Approx(3));
+        REQUIRE(best_fit(fits).b == Approx(50));
+    }
+
+    SECTION( "ignores sizes below min_size" ) {
+        std::vector<double> costs;
+        for (double n : sizes) costs.push_back(n < 1024 ? 1e9 : 2 * n);
+        std::vector<ComplexityFit> fits = fit_complexity(sizes, costs, 1024);
+        REQUIRE(best_fit(fits).model == LINEAR);
+        REQUIRE(best_fit(fits).a == Approx(2));
+    }
+
+    SECTION( "fits nothing to fewer than three points" ) {
+        REQUIRE(fit_complexity({ 64, 128 }, { 1, 2 }, 0).empty());
+    }
+}
+
+// -------------------------------------------------------------
+// Crossover test cases
+// -------------------------------------------------------------
+TEST_CASE( "crossovers" ) {
+
+    std::vector<Algorithm<int>> algorithms = { { "x", nullptr, false, 0 }, { "y", nullptr, false, 0 } };
+    std::vector<Dataset<int>> datasets = { { "d", nullptr } };
+    ResultTable<int> table(algorithms, datasets);
+
+    // Median times of x and y at sizes 16 to 1024
+    auto sweep = [&](std::vector<double> const &x, std::vector<double> const &y) {
+        for (std::size_t s = 0; s < x.size(); ++s) {
+            table.add_size(std::size_t(16) << s);
+            table.at(0, 0, s).time.median = x[s];
+            table.at(1, 0, s).time.median = y[s];
+        }
+    };
+
+    SECTION( "finds the last change of the lead" ) {
+        // y wins at 32, loses at 64 again and wins from 128 on
+        sweep({ 1, 5, 5, 10, 20, 40, 80 }, { 2, 4, 6, 8, 16, 32, 64 });
+        std::vector<Crossover> crossovers = find_crossovers(table);
+        REQUIRE(crossovers.size() == 1);
+        REQUIRE(crossovers[0].winner == 1);
+        REQUIRE(crossovers[0].loser == 0);
+        REQUIRE(crossovers[0].below == 64);
+        REQUIRE(crossovers[0].crossover == 128);
+        REQUIRE(!crossovers[0].refined);
+    }
+
+    SECTION( "finds none when one algorithm always wins" ) {
+        sweep({ 1, 2, 4, 8 }, { 2, 4, 8, 16 });
+        REQUIRE(find_crossovers(table).empty());
+    }
+
+    SECTION( "ignores skipped sizes" ) {
+        sweep({ 1, 4, 10, 40 }, { 2, 2, 8, 16 });
+        table.at(0, 0, 3).status = CellResult::SKIPPED;
+        std::vector<Crossover> crossovers = find_crossovers(table);
+        REQUIRE(crossovers.size() == 1);
+        REQUIRE(crossovers[0].below == 16);
+        REQUIRE(crossovers[0].crossover == 32);
+    }
+}
@@ -0,0 +1,73 @@
+#include "catch.hpp"
+#include "../benchmark.h"
+#include <vector>
+
+// -------------------------------------------------------------
+// Cell planning test cases
+// -------------------------------------------------------------
+TEST_CASE( "cell planning" ) {
+
+    std::vector<Algorithm<int>> algorithms = { { "quadratic", nullptr, false, 0 } };
+    std::vector<Dataset<int>> datasets = { { "d", nullptr } };
+    ResultTable<int> table(algorithms, datasets);
+
+    // One run takes 1 us at 1024 elements, 4 us at 2048 and so 16 us at 4096
+    table.add_size(1024);
+    table.add_size(2048);
+    table.at(0, 0, 0).time.trials = table.at(0, 0, 1).time.trials = 10;
+    table.at(0, 0, 0).time.median = 1000;
+    table.at(0, 0, 1).time.median = 4000;
+    const std::size_t next = table.add_size(4096);
+
+    BenchmarkConfig config(5);
+    config.warmup_runs = 1;
+
+    SECTION( "measures a cell in full without a budget" ) {
+        BenchmarkConfig planned = plan_cell(table, 0, 0, next, config);
+        REQUIRE(table.at(0, 0, next).status == CellResult::MEASURED);
+        REQUIRE(table.at(0, 0, next).predicted_ns == Approx(16000));
+        REQUIRE(planned.max_trials == config.max_trials);
+    }
+
+    SECTION( "caps the trials at what fits in the budget" ) {
+        config.time_budget_ns = 16000 * 21;
+        BenchmarkConfig planned = plan_cell(table, 0, 0, next, config);
+        REQUIRE(table.at(0, 0, next).status == CellResult::MEASURED);
+        REQUIRE(planned.max_trials == 20);
+    }
+
+    SECTION( "reduces a cell that fits fewer than the minimum trials" ) {
+        config.time_budget_ns = 16000 * 3.5;
+        BenchmarkConfig planned = plan_cell(table, 0, 0, next, config);
+        REQUIRE(table.at(0, 0, next).status == CellResult::REDUCED);
+        REQUIRE(planned.warmup_runs == 0);
+        REQUIRE(planned.min_trials == 3);
+        REQUIRE(planned.max_trials == 3);
+    }
+
+    SECTION( "skips a cell predicted to exceed the budget" ) {
+        config.time_budget_ns = 10000;
+        plan_cell(table, 0, 0, next, config);
+        REQUIRE(table.at(0, 0, next).status == CellResult::SKIPPED);
+        REQUIRE(table.at(0, 0, next).predicted_ns == Approx(16000));
+    }
+
+    SECTION( "predicts nothing past skipped sizes" ) {
+        table.at(0, 0, 0).status = CellResult::SKIPPED;
+        config.time_budget_ns = 10000;
+        plan_cell(table, 0, 0, next, config);
+        REQUIRE(table.at(0, 0, next).status == CellResult::MEASURED);
+        REQUIRE(table.at(0, 0, next).predicted_ns == 0);
+    }
+
+    SECTION( "skips sizes beyond the algorithm's maximum" ) {
+        std::vector<Algorithm<int>> capped = { { "capped", nullptr, false, 2048 } };
+        ResultTable<int> small(capped, datasets);
+        small.add_size(2048);
+        small.add_size(4096);
+        plan_cell(small, 0, 0, 0, config);
+        plan_cell(small, 0, 0, 1, config);
+        REQUIRE(small.at(0, 0, 0).status == CellResult::MEASURED);
+        REQUIRE(small.at(0, 0, 1).status == CellResult::SKIPPED);
+    }
+}
@@ -0,0 +1,162 @@
+#include "catch.hpp"
+#include "../external_sort.h"
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+
+template <typename T>
+static std::vector<T> read_file(std::string const &path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    std::vector<T> values(static_cast<std::size_t>(in.tellg()) / sizeof(T));
+    in.seekg(0);
+    in.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(T));
+    return values;
+}
+
+// -------------------------------------------------------------
+// External merge sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "external merge sort" ) {
+
+    const std::string input = "/tmp/external_sort_test.in";
+    const std::string output = "/tmp/external_sort_test.out";
+    std::string error;
+
+    SECTION( "sorts a file eight times larger than the memory budget" ) {
+        REQUIRE(write_random_file<std::int64_t>(input, 1 << 18, 42, 1 << 16, error));
+        std::vector<std::int64_t> expected = read_file<std::int64_t>(input);
+        std::sort(expected.begin(), expected.end());
+
+        ExternalSortConfig config;
+        config.memory_budget = 256 << 10;
+        config.block_size = 2 << 10;
+        OpCounter ops;
+        ExternalSortResult result = external_sort<std::int64_t>(input, output, config, ops);
+        REQUIRE(result.ok);
+        // Asynchronous I/O keeps three chunks in memory instead of one
+        REQUIRE(result.runs == (result.asynchronous_io ? 32 : 16));
+        REQUIRE(result.merge_passes == 1);
+        REQUIRE(ops.comparisons > 0);
+        REQUIRE(read_file<std::int64_t>(output) == expected);
+    }
+
+    SECTION( "merges in several passes when the budget holds few blocks" ) {
+        REQUIRE(write_random_file<std::uint32_t>(input, 1 << 16, 7, 1 << 16, error));
+        std::vector<std::uint32_t> expected = read_file<std::uint32_t>(input);
+        std::sort(expected.begin(), expected.end());
+
+        ExternalSortConfig config;
+        config.memory_budget = 16 << 10;
+        config.block_size = 4 << 10;
+        ExternalSortResult result = external_sort<std::uint32_t>(input, output, config);
+        REQUIRE(result.ok);
+        REQUIRE(result.merge_passes > 1);
+        REQUIRE(read_file<std::uint32_t>(output) == expected);
+    }
+
+    SECTION( "sorts with blocking I/O" ) {
+        REQUIRE(write_random_file<std::int64_t>(input, 1 << 16, 11, 1 << 16, error));
+        std::vector<std::int64_t> expected = read_file<std::int64_t>(input);
+        std::sort(expected.begin(), expected.end());
+
+        ExternalSortConfig config;
+        config.memory_budget = 64 << 10;
+        config.block_size = 4 << 10;
+        config.asynchronous_io = false;
+        ExternalSortResult result = external_sort<std::int64_t>(input, output, config);
+        REQUIRE(result.ok);
+        REQUIRE(!result.asynchronous_io);
+        REQUIRE(result.runs == 16);
+        REQUIRE(read_file<std::int64_t>(output) == expected);
+    }
+
+    SECTION( "sorts a file in place" ) {
+        REQUIRE(write_random_file<int>(input, 10000, 3, 1 << 12, error));
+        std::vector<int> expected = read_file<int>(input);
+        std::sort(expected.begin(), expected.end());
+
+        ExternalSortConfig config;
+        config.memory_budget = 8 << 10;
+        REQUIRE(external_sort<int>(input, input, config).ok);
+        REQUIRE(read_file<int>(input) == expected);
+    }
+
+    SECTION( "sorts a file that fits the budget and an empty file" ) {
+        REQUIRE(write_random_file<int>(input, 1000, 5, 1 << 12, error));
+        std::vector<int> expected = read_file<int>(input);
+        std::sort(expected.begin(), expected.end());
+        ExternalSortResult result = external_sort<int>(input, output, ExternalSortConfig());
+        REQUIRE(result.ok);
+        REQUIRE(result.runs == 1);
+        REQUIRE(result.merge_passes == 0);
+        REQUIRE(read_file<int>(output) == expected);
+
+        REQUIRE(write_random_file<int>(input, 0, 5, 1 << 12, error));
+        REQUIRE(external_sort<int>(input, output, ExternalSortConfig()).ok);
+        REQUIRE(read_file<int>(output).empty());
+    }
+
+    SECTION( "rejects a file that does not hold whole values" ) {
+        REQUIRE(write_random_file<char>(input, 7, 5, 1 << 12, error));
+        ExternalSortResult result = external_sort<int>(input, output, ExternalSortConfig());
+        REQUIRE(!result.ok);
+        REQUIRE(!result.error.empty());
+        REQUIRE(!external_sort<int>("/nonexistent/input", output, ExternalSortConfig()).ok);
+    }
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+// -------------------------------------------------------------
+// Memory-mapped sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "memory-mapped sort" ) {
+
+    const std::string path = "/tmp/mapped_sort_test.bin";
+    std::string error;
+
+    SECTION( "sorts a file that fits the budget in place" ) {
+        REQUIRE(write_random_file<std::int64_t>(path, 1 << 16, 13, 1 << 16, error));
+        std::vector<std::int64_t> expected = read_file<std::int64_t>(path);
+        std::sort(expected.begin(), expected.end());
+
+        OpCounter ops;
+        ExternalSortResult result = mapped_sort<std::int64_t>(path, ExternalSortConfig(), ops);
+        REQUIRE(result.ok);
+        REQUIRE(result.runs == 1);
+        REQUIRE(result.merge_passes == 0);
+        REQUIRE(ops.comparisons > 0);
+        REQUIRE(read_file<std::int64_t>(path) == expected);
+    }
+
+    SECTION( "sorts a file larger than the budget a segment at a time" ) {
+        REQUIRE(write_random_file<int>(path, 100000, 17, 1 << 16, error));
+        std::vector<int> expected = read_file<int>(path);
+        std::sort(expected.begin(), expected.end());
+
+        ExternalSortConfig config;
+        config.memory_budget = 40000;
+        config.block_size = 4 << 10;
+        ExternalSortResult result = mapped_sort<int>(path, config);
+        REQUIRE(result.ok);
+        REQUIRE(result.runs == 10);
+        REQUIRE(result.merge_passes == 1);
+        REQUIRE(read_file<int>(path) == expected);
+    }
+
+    SECTION( "sorts an empty file and rejects partial values" ) {
+        REQUIRE(write_random_file<int>(path, 0, 5, 1 << 12, error));
+        REQUIRE(mapped_sort<int>(path, ExternalSortConfig()).ok);
+        REQUIRE(read_file<int>(path).empty());
+
+        REQUIRE(write_random_file<char>(path, 6, 5, 1 << 12, error));
+        REQUIRE(!mapped_sort<int>(path, ExternalSortConfig()).ok);
+        REQUIRE(!mapped_sort<int>("/nonexistent/file", ExternalSortConfig()).ok);
+    }
+
+    std::remove(path.c_str());
+}
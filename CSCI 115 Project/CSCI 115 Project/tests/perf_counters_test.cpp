@@ -0,0 +1,57 @@
+#include "catch.hpp"
+#include "../profile.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+/**
+ * Keeps the CPU busy for about ms milliseconds.
+ */
+static void spin(int ms) {
+    const auto stop = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    while (std::chrono::steady_clock::now() < stop) {}
+}
+
+// -------------------------------------------------------------
+// Performance counter test cases
+// -------------------------------------------------------------
+TEST_CASE( "performance counters" ) {
+
+    SECTION( "charges a call only with its own threads" ) {
+        // Task-clock is a software event, available without a PMU
+        PerfCounters clock(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+        if (!clock.available()) return;
+
+        auto spawning_call = []() {
+            std::thread child(spin, 20);
+            spin(20);
+            child.join();
+        };
+
+        // Two threads cannot run for longer than twice the wall time of
+        // the call, or than the wall time on a single CPU. A thread's counts
+        // may arrive a call late, so the last three calls are added up.
+        const unsigned long long parallel = std::min(2u, std::max(1u, std::thread::hardware_concurrency()));
+        unsigned long long counted = 0, elapsed = 0;
+        for (int i = 0; i < 12; ++i) {
+            const auto begin = std::chrono::steady_clock::now();
+            clock.start();
+            spawning_call();
+            const unsigned long long count = clock.stop().cycles;
+            if (i < 9) continue;
+            counted += count;
+            elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+        }
+
+        REQUIRE(counted > 0);
+        // Counting the threads of earlier calls again would charge the
+        // last calls about five times their own time
+        REQUIRE(counted < 2 * parallel * elapsed);
+    }
+
+    SECTION( "reports counters unavailable or counts a call" ) {
+        ProfileResult result = profile_counters(spin, 5);
+        REQUIRE(result.time >= std::chrono::milliseconds(5));
+        REQUIRE(result.counters.valid == perf_counters().available());
+    }
+}
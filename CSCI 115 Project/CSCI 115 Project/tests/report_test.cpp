@@ -0,0 +1,111 @@
+#include "catch.hpp"
+#include "../report.h"
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static CellSummary summary(std::string const &algorithm, bool measured, double mean, double stddev) {
+    CellSummary cell;
+    cell.value_type = "int";
+    cell.algorithm = algorithm;
+    cell.dataset = "unsorted";
+    cell.input_size = 1024;
+    cell.measured = measured;
+    cell.trials = 30;
+    cell.median = mean;
+    cell.mean = mean;
+    cell.stddev = stddev;
+    return cell;
+}
+
+// -------------------------------------------------------------
+// Results file test cases
+// -------------------------------------------------------------
+TEST_CASE( "results file" ) {
+
+    SECTION( "parses a written cell back" ) {
+        const std::string name = "a \"quoted\" \\ name\n\twith\x01 control";
+        CellResult cell;
+        cell.time.trials = 12;
+        cell.time.median = 1500.5;
+        cell.ops.comparisons = 42;
+        cell.peak_memory = 4096;
+        cell.memory_measured = true;
+
+        std::ostringstream out;
+        write_json_cell(out, "int", name.c_str(), "unsorted", 1024, cell);
+        std::map<std::string, std::string> fields;
+        REQUIRE(parse_json_object(out.str(), fields));
+        REQUIRE(fields["type"] == "cell");
+        REQUIRE(fields["algorithm"] == name);
+        REQUIRE(fields["n"] == "1024");
+        REQUIRE(fields["status"] == "measured");
+        REQUIRE(fields["trials"] == "12");
+        REQUIRE(fields["median_ns"] == "1500.5");
+        REQUIRE(fields["comparisons"] == "42");
+        REQUIRE(fields["peak_memory_bytes"] == "4096");
+    }
+
+    SECTION( "writes no measurements of a skipped cell" ) {
+        CellResult cell;
+        cell.status = CellResult::SKIPPED;
+        std::ostringstream out;
+        write_json_cell(out, "int", "insertion", "unsorted", 1 << 20, cell);
+        std::map<std::string, std::string> fields;
+        REQUIRE(parse_json_object(out.str(), fields));
+        REQUIRE(fields["status"] == "skipped");
+        REQUIRE(fields.count("median_ns") == 0);
+    }
+
+    SECTION( "rejects lines that are not flat objects" ) {
+        std::map<std::string, std::string> fields;
+        REQUIRE(!parse_json_object("", fields));
+        REQUIRE(!parse_json_object("{\"a\": 1", fields));
+        REQUIRE(!parse_json_object("{\"a\" 1}", fields));
+        REQUIRE(!parse_json_object("{\"a\": \"open}", fields));
+        REQUIRE(parse_json_object(" { } ", fields));
+    }
+}
+
+// -------------------------------------------------------------
+// Run comparison test cases
+// -------------------------------------------------------------
+TEST_CASE( "run comparison" ) {
+
+    std::vector<CellSummary> baseline = { summary("merge", true, 1000, 10) };
+    std::ostringstream out;
+
+    SECTION( "counts a significant slowdown beyond the threshold" ) {
+        std::vector<CellSummary> candidate = { summary("merge", true, 1200, 10) };
+        REQUIRE(compare_results(baseline, candidate, 0.05, out) == 1);
+        REQUIRE(out.str().find("SLOWER") != std::string::npos);
+    }
+
+    SECTION( "does not count a slowdown within the threshold" ) {
+        std::vector<CellSummary> candidate = { summary("merge", true, 1030, 10) };
+        REQUIRE(compare_results(baseline, candidate, 0.05, out) == 0);
+    }
+
+    SECTION( "does not count a slowdown within the noise" ) {
+        std::vector<CellSummary> candidate = { summary("merge", true, 1200, 2000) };
+        REQUIRE(compare_results(baseline, candidate, 0.05, out) == 0);
+        REQUIRE(out.str().find("SLOWER") == std::string::npos);
+    }
+
+    SECTION( "counts a speedup as no slowdown" ) {
+        std::vector<CellSummary> candidate = { summary("merge", true, 800, 10) };
+        REQUIRE(compare_results(baseline, candidate, 0.05, out) == 0);
+        REQUIRE(out.str().find("faster") != std::string::npos);
+    }
+
+    SECTION( "ignores skipped cells" ) {
+        baseline.push_back(summary("quick", false, 0, 0));
+        std::vector<CellSummary> candidate = {
+            summary("merge", false, 0, 0),
+            summary("quick", true, 5000, 10),
+        };
+        REQUIRE(compare_results(baseline, candidate, 0.05, out) == 0);
+        REQUIRE(out.str().find("Compared 0 cells") == 0);
+    }
+}
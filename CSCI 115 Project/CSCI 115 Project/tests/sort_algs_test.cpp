@@ -175,6 +175,19 @@ TEST_CASE( "merge sort" ) {
         merge_sort(vec.begin(), vec.end(), count);
         REQUIRE(std::is_sorted(vec.begin(), vec.end()));
     }
+
+    SECTION( "sorts with a caller-supplied buffer reused across calls" ) {
+        std::vector<int> buffer(1000);
+        for (int round = 0; round < 3; ++round) {
+            std::vector<int> vec(1000 - round * 7);
+            for (std::size_t i = 0; i < vec.size(); ++i)
+                vec[i] = static_cast<int>((i * 7919 + round) % 101);
+            unsigned long count = 0;
+            merge_sort(vec.begin(), vec.end(), buffer.begin(), count);
+            REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+            REQUIRE(count > 0);
+        }
+    }
 }
 
 // -------------------------------------------------------------
@@ -348,4 +361,731 @@ TEST_CASE( "heap sort" ) {
         heap_sort(vec.begin(), vec.end(), count);
         REQUIRE(std::is_sorted(vec.begin(), vec.end()));
     }
-}
\ No newline at end of file
+}
+
+// -------------------------------------------------------------
+// Intro-Sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "intro sort" ) {
+
+    SECTION( "sorts empty vector" ) {
+        std::vector<int> vec;
+        unsigned long count = 0;
+        intro_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == 0);
+    }
+
+    SECTION( "sorts non-empty sorted vector" ) {
+        std::vector<int> vec = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        unsigned long count = 0;
+        intro_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count > 0);
+    }
+
+    SECTION( "sorts non-empty reverse sorted vector" ) {
+        std::vector<int> vec = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        unsigned long count = 0;
+        intro_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts non-empty unsorted vector" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 10};
+        unsigned long count = 0;
+        intro_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts vector of strings" ) {
+        std::vector<std::string> vec = {"c", "f", "a", "g", "e", "b", "d"};
+        unsigned long count = 0;
+        intro_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts large sorted, reverse sorted and few unique vectors" ) {
+        std::vector<int> sorted(10000), rsorted(10000), few_unique(10000);
+        for (int i = 0; i < 10000; ++i) {
+            sorted[i] = i;
+            rsorted[i] = 10000 - i;
+            few_unique[i] = (i * 7919) % 10;
+        }
+        unsigned long count = 0;
+        intro_sort(sorted.begin(), sorted.end(), count);
+        intro_sort(rsorted.begin(), rsorted.end(), count);
+        intro_sort(few_unique.begin(), few_unique.end(), count);
+        REQUIRE(std::is_sorted(sorted.begin(), sorted.end()));
+        REQUIRE(std::is_sorted(rsorted.begin(), rsorted.end()));
+        REQUIRE(std::is_sorted(few_unique.begin(), few_unique.end()));
+    }
+}
+
+// -------------------------------------------------------------
+// Parallel Merge-Sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "parallel merge sort" ) {
+
+    SECTION( "sorts empty vector" ) {
+        std::vector<int> vec;
+        unsigned long count = 0;
+        parallel_merge_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == 0);
+    }
+
+    SECTION( "sorts non-empty sorted vector" ) {
+        std::vector<int> vec = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        unsigned long count = 0;
+        parallel_merge_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count > 0);
+    }
+
+    SECTION( "sorts non-empty reverse sorted vector" ) {
+        std::vector<int> vec = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        unsigned long count = 0;
+        parallel_merge_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts non-empty unsorted vector" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 10};
+        unsigned long count = 0;
+        parallel_merge_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts vector of strings" ) {
+        std::vector<std::string> vec = {"c", "f", "a", "g", "e", "b", "d"};
+        unsigned long count = 0;
+        parallel_merge_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "counts the same comparisons for any number of threads" ) {
+        std::vector<int> input(100000);
+        for (std::size_t i = 0; i < input.size(); ++i)
+            input[i] = static_cast<int>((i * 7919) % 100003);
+
+        std::vector<int> vec = input;
+        unsigned long serial_count = 0;
+        parallel_merge_sort(vec.begin(), vec.end(), serial_count, 1);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+
+        for (unsigned threads : {2u, 4u, 8u}) {
+            vec = input;
+            unsigned long count = 0;
+            parallel_merge_sort(vec.begin(), vec.end(), count, threads);
+            REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+            REQUIRE(count == serial_count);
+        }
+    }
+}
+
+
+// -------------------------------------------------------------
+// Parallel Sample-Sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "parallel sample sort" ) {
+
+    SECTION( "sorts empty vector" ) {
+        std::vector<int> vec;
+        unsigned long count = 0;
+        parallel_sample_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == 0);
+    }
+
+    SECTION( "sorts non-empty sorted vector" ) {
+        std::vector<int> vec = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        unsigned long count = 0;
+        parallel_sample_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count > 0);
+    }
+
+    SECTION( "sorts non-empty reverse sorted vector" ) {
+        std::vector<int> vec = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        unsigned long count = 0;
+        parallel_sample_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts non-empty unsorted vector" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 10};
+        unsigned long count = 0;
+        parallel_sample_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts vector of strings" ) {
+        std::vector<std::string> vec = {"c", "f", "a", "g", "e", "b", "d"};
+        unsigned long count = 0;
+        parallel_sample_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts large inputs for any number of threads" ) {
+        std::vector<int> unsorted(100000), few_unique(100000), all_equal(100000, 7);
+        for (std::size_t i = 0; i < unsorted.size(); ++i) {
+            unsorted[i] = static_cast<int>((i * 7919) % 100003);
+            few_unique[i] = static_cast<int>((i * 7919) % 5);
+        }
+
+        for (std::vector<int> const &input : {unsorted, few_unique, all_equal}) {
+            std::vector<int> expected = input;
+            std::sort(expected.begin(), expected.end());
+            for (unsigned threads : {1u, 2u, 8u, 64u}) {
+                std::vector<int> vec = input;
+                OpCounter ops;
+                parallel_sample_sort(vec.begin(), vec.end(), ops, threads);
+                REQUIRE(vec == expected);
+                REQUIRE(ops.comparisons > 0);
+            }
+        }
+    }
+
+    SECTION( "sorts large inputs of strings" ) {
+        std::vector<std::string> vec(50000);
+        for (std::size_t i = 0; i < vec.size(); ++i)
+            vec[i] = std::to_string((i * 7919) % 1000);
+        std::vector<std::string> expected = vec;
+        std::sort(expected.begin(), expected.end());
+        unsigned long count = 0;
+        parallel_sample_sort(vec.begin(), vec.end(), count, 4);
+        REQUIRE(vec == expected);
+    }
+
+    SECTION( "keeps its thread pool across calls" ) {
+        std::vector<int> vec(100000);
+        WorkStealingPool *pool = nullptr;
+        for (int call = 0; call < 3; ++call) {
+            for (std::size_t i = 0; i < vec.size(); ++i)
+                vec[i] = static_cast<int>((i * 7919) % 100003);
+            unsigned long count = 0;
+            parallel_sample_sort(vec.begin(), vec.end(), count, 4);
+            REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+            if (call == 0) pool = &thread_pool_for(4);
+            REQUIRE(&thread_pool_for(4) == pool);
+        }
+    }
+}
+
+// -------------------------------------------------------------
+// In-Place Sample-Sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "in-place sample sort" ) {
+
+    SECTION( "sorts empty vector" ) {
+        std::vector<int> vec;
+        unsigned long count = 0;
+        in_place_sample_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == 0);
+    }
+
+    SECTION( "sorts non-empty sorted vector" ) {
+        std::vector<int> vec = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        unsigned long count = 0;
+        in_place_sample_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count > 0);
+    }
+
+    SECTION( "sorts non-empty reverse sorted vector" ) {
+        std::vector<int> vec = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        unsigned long count = 0;
+        in_place_sample_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts non-empty unsorted vector" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 10};
+        unsigned long count = 0;
+        in_place_sample_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts vector of strings" ) {
+        std::vector<std::string> vec = {"c", "f", "a", "g", "e", "b", "d"};
+        unsigned long count = 0;
+        in_place_sample_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts large inputs for any number of threads" ) {
+        std::vector<int> unsorted(100000), few_unique(100000), all_equal(100000, 7);
+        for (std::size_t i = 0; i < unsorted.size(); ++i) {
+            unsorted[i] = static_cast<int>((i * 7919) % 100003);
+            few_unique[i] = static_cast<int>((i * 7919) % 5);
+        }
+
+        for (std::vector<int> const &input : {unsorted, few_unique, all_equal}) {
+            std::vector<int> expected = input;
+            std::sort(expected.begin(), expected.end());
+            for (unsigned threads : {1u, 2u, 8u, 64u}) {
+                std::vector<int> vec = input;
+                OpCounter ops;
+                in_place_sample_sort(vec.begin(), vec.end(), ops, threads);
+                REQUIRE(vec == expected);
+                REQUIRE(ops.comparisons > 0);
+            }
+        }
+    }
+
+    SECTION( "sorts sizes that are not a multiple of the block" ) {
+        for (std::size_t size : {16385u, 100001u, 262144u, 262147u}) {
+            std::vector<int> vec(size);
+            for (std::size_t i = 0; i < vec.size(); ++i)
+                vec[i] = static_cast<int>((i * 7919) % 1000003);
+            std::vector<int> expected = vec;
+            std::sort(expected.begin(), expected.end());
+            unsigned long count = 0;
+            in_place_sample_sort(vec.begin(), vec.end(), count, 3);
+            REQUIRE(vec == expected);
+        }
+    }
+
+    SECTION( "sorts large inputs of strings" ) {
+        std::vector<std::string> vec(50000);
+        for (std::size_t i = 0; i < vec.size(); ++i)
+            vec[i] = std::to_string((i * 7919) % 1000);
+        std::vector<std::string> expected = vec;
+        std::sort(expected.begin(), expected.end());
+        unsigned long count = 0;
+        in_place_sample_sort(vec.begin(), vec.end(), count, 4);
+        REQUIRE(vec == expected);
+    }
+}
+
+// -------------------------------------------------------------
+// LSD Radix-Sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "lsd radix sort" ) {
+
+    SECTION( "sorts empty vector" ) {
+        std::vector<int> vec;
+        unsigned long count = 0;
+        lsd_radix_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == 0);
+    }
+
+    SECTION( "sorts non-empty sorted vector" ) {
+        std::vector<int> vec = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        unsigned long count = 0;
+        lsd_radix_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count > 0);
+    }
+
+    SECTION( "sorts non-empty reverse sorted vector" ) {
+        std::vector<int> vec = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        unsigned long count = 0;
+        lsd_radix_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts non-empty unsorted vector" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 10};
+        unsigned long count = 0;
+        lsd_radix_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts negative and 64-bit values" ) {
+        std::vector<int> vec = {5, -1, 400000, -2147483647 - 1, 3, 2147483647, -65536, 0};
+        std::vector<long long> wide = {1LL << 40, -(1LL << 50), 7, -7, 0, 1LL << 62};
+        std::vector<unsigned> unsigned_vec = {4000000000u, 1, 65536, 0, 255};
+        unsigned long count = 0;
+        lsd_radix_sort(vec.begin(), vec.end(), count);
+        lsd_radix_sort(wide.begin(), wide.end(), count);
+        lsd_radix_sort(unsigned_vec.begin(), unsigned_vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(std::is_sorted(wide.begin(), wide.end()));
+        REQUIRE(std::is_sorted(unsigned_vec.begin(), unsigned_vec.end()));
+    }
+
+    SECTION( "skips digits shared by every key" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 0, 3, 3};
+        unsigned long count = 0;
+        lsd_radix_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == 2 * vec.size()); // histogram pass plus the low digit
+    }
+}
+
+
+// -------------------------------------------------------------
+// Block-Quick-Sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "block quick sort" ) {
+
+    SECTION( "sorts empty vector" ) {
+        std::vector<int> vec;
+        unsigned long count = 0;
+        block_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == 0);
+    }
+
+    SECTION( "sorts non-empty sorted vector" ) {
+        std::vector<int> vec = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        unsigned long count = 0;
+        block_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count > 0);
+    }
+
+    SECTION( "sorts non-empty reverse sorted vector" ) {
+        std::vector<int> vec = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        unsigned long count = 0;
+        block_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts non-empty unsorted vector" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 10};
+        unsigned long count = 0;
+        block_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts vector of strings" ) {
+        std::vector<std::string> vec = {"c", "f", "a", "g", "e", "b", "d"};
+        unsigned long count = 0;
+        block_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts large patterned and few unique vectors" ) {
+        std::vector<int> sorted(10000), organ_pipe(10000), few_unique(10000);
+        for (int i = 0; i < 10000; ++i) {
+            sorted[i] = i;
+            organ_pipe[i] = i < 5000 ? i : 10000 - i;
+            few_unique[i] = (i * 7919) % 10;
+        }
+        unsigned long count = 0;
+        block_quick_sort(sorted.begin(), sorted.end(), count);
+        block_quick_sort(organ_pipe.begin(), organ_pipe.end(), count);
+        block_quick_sort(few_unique.begin(), few_unique.end(), count);
+        REQUIRE(std::is_sorted(sorted.begin(), sorted.end()));
+        REQUIRE(std::is_sorted(organ_pipe.begin(), organ_pipe.end()));
+        REQUIRE(std::is_sorted(few_unique.begin(), few_unique.end()));
+    }
+}
+
+
+// -------------------------------------------------------------
+// Tim-Sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "tim sort" ) {
+
+    SECTION( "sorts empty vector" ) {
+        std::vector<int> vec;
+        unsigned long count = 0;
+        tim_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == 0);
+    }
+
+    SECTION( "sorts non-empty sorted vector" ) {
+        std::vector<int> vec = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        unsigned long count = 0;
+        tim_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count > 0);
+    }
+
+    SECTION( "sorts non-empty reverse sorted vector" ) {
+        std::vector<int> vec = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        unsigned long count = 0;
+        tim_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts non-empty unsorted vector" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 10};
+        unsigned long count = 0;
+        tim_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts vector of strings" ) {
+        std::vector<std::string> vec = {"c", "f", "a", "g", "e", "b", "d"};
+        unsigned long count = 0;
+        tim_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "uses n - 1 comparisons on sorted input" ) {
+        std::vector<int> vec(10000);
+        for (int i = 0; i < 10000; ++i) vec[i] = i;
+        unsigned long count = 0;
+        tim_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == vec.size() - 1);
+    }
+
+    SECTION( "preserves the order of equal elements" ) {
+        // Compares on the key only so equal keys keep their positions visible
+        struct Keyed {
+            int key;
+            int position;
+            bool operator<(Keyed const &other) const { return key < other.key; }
+        };
+        std::vector<Keyed> vec;
+        for (int i = 0; i < 10000; ++i) vec.push_back(Keyed{(i * 7919) % 10, i});
+
+        unsigned long count = 0;
+        tim_sort(vec.begin(), vec.end(), count);
+        bool stable = true;
+        for (std::size_t i = 1; i < vec.size(); ++i) {
+            if (vec[i].key < vec[i - 1].key) stable = false;
+            if (vec[i - 1].key == vec[i].key && vec[i].position < vec[i - 1].position) stable = false;
+        }
+        REQUIRE(stable);
+    }
+}
+
+
+// -------------------------------------------------------------
+// Three-Way-Quick-Sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "three way quick sort" ) {
+
+    SECTION( "sorts empty vector" ) {
+        std::vector<int> vec;
+        unsigned long count = 0;
+        three_way_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == 0);
+    }
+
+    SECTION( "sorts non-empty sorted vector" ) {
+        std::vector<int> vec = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        unsigned long count = 0;
+        three_way_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count > 0);
+    }
+
+    SECTION( "sorts non-empty reverse sorted vector" ) {
+        std::vector<int> vec = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        unsigned long count = 0;
+        three_way_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts non-empty unsorted vector" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 10};
+        unsigned long count = 0;
+        three_way_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts vector of strings" ) {
+        std::vector<std::string> vec = {"c", "f", "a", "g", "e", "b", "d"};
+        unsigned long count = 0;
+        three_way_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts few unique keys in linear time" ) {
+        std::vector<int> vec(100000);
+        for (std::size_t i = 0; i < vec.size(); ++i) vec[i] = static_cast<int>((i * 7919) % 10);
+        unsigned long count = 0;
+        three_way_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count < 10 * vec.size());
+    }
+}
+
+
+// -------------------------------------------------------------
+// Dual-Pivot-Quick-Sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "dual pivot quick sort" ) {
+
+    SECTION( "sorts empty vector" ) {
+        std::vector<int> vec;
+        unsigned long count = 0;
+        dual_pivot_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == 0);
+    }
+
+    SECTION( "sorts non-empty sorted vector" ) {
+        std::vector<int> vec = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        unsigned long count = 0;
+        dual_pivot_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count > 0);
+    }
+
+    SECTION( "sorts non-empty reverse sorted vector" ) {
+        std::vector<int> vec = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        unsigned long count = 0;
+        dual_pivot_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts non-empty unsorted vector" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 10};
+        unsigned long count = 0;
+        dual_pivot_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts vector of strings" ) {
+        std::vector<std::string> vec = {"c", "f", "a", "g", "e", "b", "d"};
+        unsigned long count = 0;
+        dual_pivot_quick_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts large sorted, reverse sorted and few unique vectors" ) {
+        std::vector<int> sorted(10000), rsorted(10000), few_unique(10000);
+        for (int i = 0; i < 10000; ++i) {
+            sorted[i] = i;
+            rsorted[i] = 10000 - i;
+            few_unique[i] = (i * 7919) % 10;
+        }
+        unsigned long count = 0;
+        dual_pivot_quick_sort(sorted.begin(), sorted.end(), count);
+        dual_pivot_quick_sort(rsorted.begin(), rsorted.end(), count);
+        dual_pivot_quick_sort(few_unique.begin(), few_unique.end(), count);
+        REQUIRE(std::is_sorted(sorted.begin(), sorted.end()));
+        REQUIRE(std::is_sorted(rsorted.begin(), rsorted.end()));
+        REQUIRE(std::is_sorted(few_unique.begin(), few_unique.end()));
+    }
+}
+
+
+// -------------------------------------------------------------
+// Small-Sort test cases
+// -------------------------------------------------------------
+TEST_CASE( "small sort" ) {
+
+    SECTION( "sorts empty vector" ) {
+        std::vector<int> vec;
+        unsigned long count = 0;
+        small_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count == 0);
+    }
+
+    SECTION( "sorts non-empty sorted vector" ) {
+        std::vector<int> vec = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        unsigned long count = 0;
+        small_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+        REQUIRE(count > 0);
+    }
+
+    SECTION( "sorts non-empty reverse sorted vector" ) {
+        std::vector<int> vec = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        unsigned long count = 0;
+        small_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts non-empty unsorted vector" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 10};
+        unsigned long count = 0;
+        small_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts vector of strings" ) {
+        std::vector<std::string> vec = {"c", "f", "a", "g", "e", "b", "d"};
+        unsigned long count = 0;
+        small_sort(vec.begin(), vec.end(), count);
+        REQUIRE(std::is_sorted(vec.begin(), vec.end()));
+    }
+
+    SECTION( "sorts every int range size up to SMALL_SORT_MAX" ) {
+        for (int n = 0; n <= SMALL_SORT_MAX; ++n) {
+            std::vector<int> vec(n);
+            for (int i = 0; i < n; ++i) vec[i] = ((i * 7919) % 13) - 6 + (i % 3 == 0 ? INT_MAX - 6 : 0);
+            std::vector<int> expected = vec;
+            std::sort(expected.begin(), expected.end());
+            unsigned long count = 0;
+            small_sort(vec.begin(), vec.end(), count);
+            REQUIRE(vec == expected);
+        }
+    }
+}
+
+// -------------------------------------------------------------
+// Counting policy test cases
+// -------------------------------------------------------------
+TEST_CASE( "counting policies" ) {
+
+    SECTION( "OpCounter counts the same comparisons as unsigned long" ) {
+        std::vector<int> vec = {5, 1, 4, 2, 3, 9, 6, 8, 7, 10};
+        std::vector<int> copy = vec;
+        unsigned long count = 0;
+        OpCounter ops;
+        intro_sort(vec.begin(), vec.end(), count);
+        intro_sort(copy.begin(), copy.end(), ops);
+        REQUIRE(ops.comparisons == count);
+        REQUIRE(vec == copy);
+    }
+
+    SECTION( "OpCounter counts moves" ) {
+        std::vector<int> sorted = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        std::vector<int> reversed = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+        OpCounter sorted_ops, reversed_ops;
+        insertion_sort(sorted.begin(), sorted.end(), sorted_ops);
+        insertion_sort(reversed.begin(), reversed.end(), reversed_ops);
+        REQUIRE(reversed_ops.moves == 2 * 9 + 45);
+        REQUIRE(reversed_ops.moves > sorted_ops.moves);
+    }
+
+    SECTION( "sorts without a counter" ) {
+        std::vector<int> vec(1000);
+        for (int i = 0; i < 1000; ++i) vec[i] = (i * 7919) % 1009;
+        std::vector<int> expected = vec;
+        std::sort(expected.begin(), expected.end());
+
+        std::vector<int> a = vec, b = vec, c = vec, d = vec, e = vec, f = vec, g = vec;
+        std::vector<int> h = vec, i = vec, j = vec, k = vec, scratch(vec.size());
+        block_quick_sort(a.begin(), a.end());
+        tim_sort(b.begin(), b.end());
+        parallel_merge_sort(c.begin(), c.end());
+        lsd_radix_sort(d.begin(), d.end());
+        dual_pivot_quick_sort(e.begin(), e.end());
+        parallel_sample_sort(f.begin(), f.end());
+        in_place_sample_sort(g.begin(), g.end());
+        quick_sort(h.begin(), h.end());
+        hoare_quick_sort(i.begin(), i.end());
+        randomized_quick_sort(j.begin(), j.end());
+        merge_sort(k.begin(), k.end(), scratch.begin());
+        REQUIRE(a == expected);
+        REQUIRE(b == expected);
+        REQUIRE(c == expected);
+        REQUIRE(d == expected);
+        REQUIRE(e == expected);
+        REQUIRE(f == expected);
+        REQUIRE(g == expected);
+        REQUIRE(h == expected);
+        REQUIRE(i == expected);
+        REQUIRE(j == expected);
+        REQUIRE(k == expected);
+
+        // An lvalue buffer, which must not be taken for a counter
+        std::vector<int>::iterator buffer = scratch.begin();
+        k = vec;
+        merge_sort(k.begin(), k.end(), buffer);
+        REQUIRE(k == expected);
+
+        std::vector<int> empty;
+        quick_sort(empty.begin(), empty.end());
+        hoare_quick_sort(empty.begin(), empty.end());
+        randomized_quick_sort(empty.begin(), empty.end());
+        REQUIRE(empty.empty());
+    }
+}
@@ -0,0 +1,123 @@
+#include "catch.hpp"
+#include "../stats.h"
+#include <vector>
+
+// -------------------------------------------------------------
+// Percentile test cases
+// -------------------------------------------------------------
+TEST_CASE( "percentile" ) {
+
+    const std::vector<double> sorted = {1, 2, 3, 4};
+
+    SECTION( "interpolates between the closest ranks" ) {
+        REQUIRE(percentile(sorted, 0.5) == Approx(2.5));
+        REQUIRE(percentile(sorted, 0.25) == Approx(1.75));
+        REQUIRE(percentile(sorted, 0.9) == Approx(3.7));
+    }
+
+    SECTION( "returns the ends at 0 and 1" ) {
+        REQUIRE(percentile(sorted, 0) == 1);
+        REQUIRE(percentile(sorted, 1) == 4);
+    }
+
+    SECTION( "returns 0 for no samples" ) {
+        REQUIRE(percentile(std::vector<double>(), 0.5) == 0);
+    }
+}
+
+// -------------------------------------------------------------
+// Outlier rejection test cases
+// -------------------------------------------------------------
+TEST_CASE( "outlier rejection" ) {
+
+    SECTION( "removes samples outside Tukey's fences" ) {
+        // Quartiles 12 and 16, so the fences are at 6 and 22
+        std::vector<double> samples = {100, 12, 10, 13, 1, 14, 15, 16, 17};
+        REQUIRE(reject_outliers(samples) == 2);
+        REQUIRE(samples == std::vector<double>({12, 10, 13, 14, 15, 16, 17}));
+    }
+
+    SECTION( "keeps samples without outliers" ) {
+        std::vector<double> samples = {10, 11, 12, 13, 14};
+        REQUIRE(reject_outliers(samples) == 0);
+        REQUIRE(samples.size() == 5);
+    }
+
+    SECTION( "keeps fewer than four samples" ) {
+        std::vector<double> samples = {1, 2, 1000};
+        REQUIRE(reject_outliers(samples) == 0);
+        REQUIRE(samples.size() == 3);
+    }
+}
+
+// -------------------------------------------------------------
+// Summary and confidence interval test cases
+// -------------------------------------------------------------
+TEST_CASE( "timing summary" ) {
+
+    // Mean 100, standard deviation sqrt(2.5)
+    const std::vector<double> samples = {102, 98, 101, 100, 99};
+
+    SECTION( "computes the relative confidence interval" ) {
+        // t(4) = 2.776
+        REQUIRE(relative_confidence_interval(samples) == Approx(2.776 * std::sqrt(2.5) / std::sqrt(5.0) / 100));
+        REQUIRE(relative_confidence_interval({100}) == INFINITY);
+    }
+
+    SECTION( "stops trials once the interval is within the target" ) {
+        REQUIRE(relative_confidence_interval(samples) <= 0.02);
+        REQUIRE(relative_confidence_interval(samples) > 0.01);
+        std::vector<double> more = samples;
+        more.insert(more.end(), samples.begin(), samples.end());
+        more.insert(more.end(), samples.begin(), samples.end());
+        REQUIRE(relative_confidence_interval(more) <= 0.01);
+    }
+
+    SECTION( "summarizes known samples" ) {
+        TimingStats stats = summarize(samples, 50, false);
+        REQUIRE(stats.trials == 5);
+        REQUIRE(stats.outliers == 0);
+        REQUIRE(stats.min == 98);
+        REQUIRE(stats.median == 100);
+        REQUIRE(stats.p90 == Approx(101.6));
+        REQUIRE(stats.mean == Approx(100));
+        REQUIRE(stats.stddev == Approx(std::sqrt(2.5)));
+        REQUIRE(stats.ns_per_element == Approx(2));
+        REQUIRE(stats.elements_per_second == Approx(5e8));
+    }
+
+    SECTION( "summarizes without the outliers" ) {
+        std::vector<double> noisy = samples;
+        noisy.push_back(1000);
+        TimingStats stats = summarize(noisy, 50, true);
+        REQUIRE(stats.trials == 5);
+        REQUIRE(stats.outliers == 1);
+        REQUIRE(stats.mean == Approx(100));
+        REQUIRE(summarize(noisy, 50, false).trials == 6);
+    }
+}
+
+// -------------------------------------------------------------
+// Power law prediction test cases
+// -------------------------------------------------------------
+TEST_CASE( "power law prediction" ) {
+
+    const std::vector<double> sizes = {100, 200, 400};
+
+    SECTION( "predicts the next size of a quadratic series" ) {
+        std::vector<double> times;
+        for (double n : sizes) times.push_back(2 * n * n);
+        REQUIRE(predict_power_law(sizes, times, 800) == Approx(2 * 800.0 * 800.0));
+    }
+
+    SECTION( "keeps the exponent at 1 or above" ) {
+        // Constant times would predict no growth at all
+        REQUIRE(predict_power_law(sizes, {50, 50, 50}, 800) == Approx(200));
+        REQUIRE(predict_power_law(sizes, {400, 200, 100}, 800) > 100);
+    }
+
+    SECTION( "predicts nothing from fewer than two points" ) {
+        REQUIRE(predict_power_law({100}, {5}, 200) == 0);
+        REQUIRE(predict_power_law(sizes, {0, 0, 5}, 800) == 0);
+    }
+}
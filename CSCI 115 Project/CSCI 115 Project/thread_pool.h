@@ -0,0 +1,223 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+inline std::atomic<unsigned> &thread_count_override()
+{
+    static std::atomic<unsigned> count(0);
+    return count;
+}
+
+/**
+ * Returns the number of threads parallel algorithms use when not told
+ * otherwise: the count set with set_default_thread_count, or else the
+ * number of hardware threads, or 1 when it cannot be determined.
+ */
+inline unsigned default_thread_count()
+{
+    unsigned n = thread_count_override().load(std::memory_order_relaxed);
+    if (n == 0) n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+/**
+ * Makes default_thread_count return count, such as the number of CPUs the
+ * process is restricted to, or the number of hardware threads again when
+ * count is 0.
+ */
+inline void set_default_thread_count(unsigned count)
+{
+    thread_count_override() = count;
+}
+
+/**
+ * Fixed-size pool of threads for fork-join work. Every thread owns a deque of
+ * tasks: it pushes and pops its own tasks at the back and, when its deque is
+ * empty, steals the oldest task from the front of another thread's deque.
+ *
+ * The thread that created the pool takes part as well: it owns deque 0 and
+ * runs tasks while it blocks in wait(), so a pool of n threads only starts
+ * n - 1 workers.
+ */
+class WorkStealingPool {
+public:
+    typedef std::function<void()> Task;
+
+    /**
+     * @param num_threads total number of threads working on tasks, including
+     *              the thread that calls wait(). Values below 1 are raised to 1.
+     */
+    explicit WorkStealingPool(unsigned num_threads):
+        queued(0),
+        stopping(false)
+    {
+        if (num_threads < 1) num_threads = 1;
+        for (unsigned i = 0; i < num_threads; ++i)
+            queues.push_back(std::unique_ptr<Queue>(new Queue()));
+        for (unsigned i = 1; i < num_threads; ++i)
+            workers.emplace_back(&WorkStealingPool::worker_loop, this, i);
+    }
+
+    ~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(sleep_lock);
+            stopping = true;
+        }
+        sleep_cv.notify_all();
+        for (auto &worker : workers) worker.join();
+    }
+
+    WorkStealingPool(WorkStealingPool const &) = delete;
+    WorkStealingPool &operator=(WorkStealingPool const &) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    /**
+     * Returns the index of the calling thread in [0, size()): 0 for the
+     * thread that created the pool and for threads outside it.
+     */
+    unsigned thread_index() const { return self(); }
+
+    /**
+     * Queues task on the deque of the calling thread.
+     */
+    void submit(Task task)
+    {
+        Queue &queue = *queues[self()];
+        {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            queue.tasks.push_back(std::move(task));
+        }
+        queued++;
+
+        // Taking the lock orders this wake-up after a sleeper's predicate check
+        { std::lock_guard<std::mutex> guard(sleep_lock); }
+        sleep_cv.notify_one();
+    }
+
+    /**
+     * Runs task(i) for every i in [0, count) as separate tasks and returns
+     * once all of them are done. The calling thread runs tasks meanwhile.
+     */
+    template <typename F>
+    void run_all(std::size_t count, F const &task)
+    {
+        std::atomic<std::size_t> pending(count);
+        for (std::size_t i = 0; i < count; ++i)
+            submit([&task, &pending, i]() { task(i); pending--; });
+        wait(pending);
+    }
+
+    /**
+     * Runs queued tasks until pending drops to zero. Tasks are expected to
+     * decrement pending as their last action.
+     */
+    void wait(std::atomic<std::size_t> const &pending)
+    {
+        const unsigned me = self();
+        while (pending.load() != 0)
+        {
+            if (!try_run_one(me)) std::this_thread::yield();
+        }
+    }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    static WorkStealingPool const *&current_pool()
+    {
+        static thread_local WorkStealingPool const *pool = nullptr;
+        return pool;
+    }
+
+    static unsigned &current_index()
+    {
+        static thread_local unsigned index = 0;
+        return index;
+    }
+
+    unsigned self() const
+    {
+        return current_pool() == this ? current_index() : 0;
+    }
+
+    bool try_run_one(unsigned me)
+    {
+        Task task;
+        const unsigned n = size();
+
+        // Newest task from our own deque first, it is the hottest in cache
+        for (unsigned k = 0; k < n && !task; ++k)
+        {
+            Queue &queue = *queues[(me + k) % n];
+            std::lock_guard<std::mutex> guard(queue.lock);
+            if (queue.tasks.empty()) continue;
+            if (k == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+        if (!task) return false;
+
+        queued--;
+        task();
+        return true;
+    }
+
+    void worker_loop(unsigned me)
+    {
+        current_pool() = this;
+        current_index() = me;
+
+        while (true)
+        {
+            if (try_run_one(me)) continue;
+
+            std::unique_lock<std::mutex> guard(sleep_lock);
+            sleep_cv.wait(guard, [this] { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() == 0) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> queued;
+    std::mutex sleep_lock;
+    std::condition_variable sleep_cv;
+    bool stopping;
+};
+
+/**
+ * Returns a pool of num_threads threads owned by the calling thread. The
+ * pool is kept alive between calls, so that a fork-join algorithm called
+ * over and over does not start and join its threads every time, and is
+ * replaced when num_threads changes. Its workers sleep while it is idle.
+ *
+ * Must not be called from a task of the returned pool with another
+ * num_threads, as that would destroy the pool the task runs on.
+ */
+inline WorkStealingPool &thread_pool_for(unsigned num_threads)
+{
+    static thread_local std::unique_ptr<WorkStealingPool> pool;
+    if (num_threads < 1) num_threads = 1;
+    if (!pool || pool->size() != num_threads) pool.reset(new WorkStealingPool(num_threads));
+    return *pool;
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef VALUE_TYPES_H
+#define VALUE_TYPES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// -----------------------------------------------------------
+// Value types the benchmark sorts
+//
+// Every dataset is generated as a sequence of 64-bit integer keys, and
+// make_value turns a key into the value of each type. The conversion keeps
+// the order of the keys, so a sorted dataset is sorted for every type and
+// duplicates stay duplicates, and the types see equivalent inputs.
+// -----------------------------------------------------------
+
+/**
+ * A fixed-size record of Bytes bytes ordered by its key, like a row sorted
+ * by one column. The payload is moved along with the key, so the cost of
+ * every element move grows with the record.
+ */
+template <std::size_t Bytes>
+struct Record {
+    static_assert(Bytes > sizeof(std::int64_t), "a Record holds a key and a payload");
+
+    std::int64_t key;
+    unsigned char payload[Bytes - sizeof(std::int64_t)];
+};
+
+template <std::size_t Bytes> bool operator<(Record<Bytes> const &a, Record<Bytes> const &b) { return a.key < b.key; }
+template <std::size_t Bytes> bool operator>(Record<Bytes> const &a, Record<Bytes> const &b) { return a.key > b.key; }
+template <std::size_t Bytes> bool operator<=(Record<Bytes> const &a, Record<Bytes> const &b) { return a.key <= b.key; }
+template <std::size_t Bytes> bool operator>=(Record<Bytes> const &a, Record<Bytes> const &b) { return a.key >= b.key; }
+template <std::size_t Bytes> bool operator==(Record<Bytes> const &a, Record<Bytes> const &b) { return a.key == b.key; }
+template <std::size_t Bytes> bool operator!=(Record<Bytes> const &a, Record<Bytes> const &b) { return a.key != b.key; }
+
+/**
+ * Returns the value of type T for key. Integer types narrower than 64 bits
+ * keep the low bits of the key.
+ */
+template <typename T>
+T make_value(std::int64_t key)
+{
+    return static_cast<T>(key);
+}
+
+/**
+ * Strings are the 16 hexadecimal digits of the key with its sign bit
+ * flipped, which order like the keys, negative ones included.
+ */
+template <>
+inline std::string make_value<std::string>(std::int64_t key)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::uint64_t bits = static_cast<std::uint64_t>(key) ^ (std::uint64_t(1) << 63);
+    std::string value(16, '0');
+    for (int i = 15; i >= 0; --i, bits >>= 4) value[i] = digits[bits & 0xF];
+    return value;
+}
+
+/**
+ * Fills the payload of a record from its key, so records are not mostly
+ * zero pages the kernel could share.
+ */
+template <std::size_t Bytes>
+Record<Bytes> make_record(std::int64_t key)
+{
+    Record<Bytes> record;
+    record.key = key;
+    for (std::size_t i = 0; i < sizeof(record.payload); ++i)
+        record.payload[i] = static_cast<unsigned char>(key + i);
+    return record;
+}
+
+template <> inline Record<32> make_value<Record<32>>(std::int64_t key) { return make_record<32>(key); }
+template <> inline Record<64> make_value<Record<64>>(std::int64_t key) { return make_record<64>(key); }
+template <> inline Record<128> make_value<Record<128>>(std::int64_t key) { return make_record<128>(key); }
+
+/**
+ * Returns the name of a value type, as used on the command line and in the
+ * names of result files.
+ */
+template <typename T> char const *value_type_name();
+template <> inline char const *value_type_name<int>() { return "int"; }
+template <> inline char const *value_type_name<std::int64_t>() { return "int64"; }
+template <> inline char const *value_type_name<double>() { return "double"; }
+template <> inline char const *value_type_name<std::string>() { return "string"; }
+template <> inline char const *value_type_name<Record<32>>() { return "record32"; }
+template <> inline char const *value_type_name<Record<64>>() { return "record64"; }
+template <> inline char const *value_type_name<Record<128>>() { return "record128"; }
+
+#endif